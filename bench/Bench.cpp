@@ -0,0 +1,514 @@
+// bomber_bench: microbenchmarks for the simulation hot paths.
+//
+//   bomber_bench [-f <filter>] [-n <samples>] [-o results.csv] [-b baseline.csv]
+//
+// Every benchmark is warmed up, then timed as a number of samples, each
+// long enough (about 2 ms) that the clock resolution doesn't matter. The
+// median and the median absolute deviation (MAD) are reported, so a single
+// preempted sample doesn't move the result.
+//
+// To check an optimization, save a run with -o before the change and pass
+// it with -b after: each benchmark shows the change in median, and marks it
+// only when it is larger than the noise of both runs together. Runs are
+// only comparable on the same machine with nothing else busy.
+
+#include "BenchUtil.h"
+#include "FlowField.h"
+#include "LevelManager.h"
+#include "Snapshot.h"
+#include "SpatialHash.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Keeps results alive so the compiler can't drop the measured work
+static volatile uint64_t sink;
+
+struct BenchResult {
+    std::string name;
+    SampleStats stats;  // nanoseconds per operation
+    long long iterations;
+};
+
+class BenchRunner {
+private:
+    std::string filter;
+    int sampleCount;
+    std::vector<BenchResult> results;
+
+    template <typename Func>
+    static double TimeBatch(Func& body, long long iterations) {
+        auto start = std::chrono::steady_clock::now();
+        for (long long i = 0; i < iterations; i++) {
+            body();
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+
+public:
+    BenchRunner(const std::string& nameFilter, int samples) : filter(nameFilter), sampleCount(samples) {}
+
+    bool Wants(const std::string& name) const {
+        return filter.empty() || name.find(filter) != std::string::npos;
+    }
+
+    template <typename Func>
+    void Run(const std::string& name, Func&& body) {
+        if (!Wants(name)) return;
+
+        // Grow the batch until one sample takes long enough, this doubles
+        // as the warmup
+        long long iterations = 1;
+        while (TimeBatch(body, iterations) < 2e6 && iterations < (1ll << 30)) {
+            iterations *= 2;
+        }
+
+        std::vector<double> samples;
+        for (int i = 0; i < sampleCount; i++) {
+            samples.push_back(TimeBatch(body, iterations) / iterations);
+        }
+
+        BenchResult result = {name, ComputeStats(samples), iterations};
+        results.push_back(result);
+        std::printf("%-44s %12.1f ns  min %12.1f  mad %5.1f%%  (%lld x %d)\n", name.c_str(),
+                    result.stats.median, result.stats.min, 100.0 * result.stats.mad / result.stats.median,
+                    iterations, sampleCount);
+        std::fflush(stdout);
+    }
+
+    const std::vector<BenchResult>& GetResults() const {
+        return results;
+    }
+};
+
+static bool SaveResults(const std::vector<BenchResult>& results, const std::string& path) {
+    std::ofstream out(path);
+    if (!out) return false;
+    out << "name,median_ns,mad_ns,min_ns,iterations\n";
+    for (const BenchResult& result : results) {
+        out << result.name << "," << result.stats.median << "," << result.stats.mad << ","
+            << result.stats.min << "," << result.iterations << "\n";
+    }
+    return (bool)out;
+}
+
+static void CompareWithBaseline(const std::vector<BenchResult>& results, const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "cannot open " << path << std::endl;
+        return;
+    }
+
+    // name -> median, mad
+    std::map<std::string, std::pair<double, double>> baseline;
+    std::string line;
+    std::getline(in, line);
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string name, median, mad;
+        if (std::getline(fields, name, ',') && std::getline(fields, median, ',') && std::getline(fields, mad, ',')) {
+            baseline[name] = {std::atof(median.c_str()), std::atof(mad.c_str())};
+        }
+    }
+
+    std::printf("\ncompared with %s:\n", path.c_str());
+    for (const BenchResult& result : results) {
+        auto it = baseline.find(result.name);
+        if (it == baseline.end() || it->second.first <= 0) continue;
+
+        double before = it->second.first;
+        double change = (result.stats.median - before) / before * 100.0;
+        // Anything inside the combined spread of the two runs is noise, and
+        // so is a few percent of drift between runs
+        double noise = std::max(2.0 * (it->second.second + result.stats.mad), 0.03 * before);
+        const char* verdict = std::fabs(result.stats.median - before) <= noise ? "same"
+                              : (result.stats.median < before ? "FASTER" : "SLOWER");
+        std::printf("%-44s %+7.1f%%  %s\n", result.name.c_str(), change, verdict);
+    }
+}
+
+static void LoadGenerated(LevelManager& level, const GeneratedLevel& generated) {
+    level.LoadLevel(generated.header, generated.tiles.data());
+}
+
+// Open cells around the spawn, away from walls, where a bullet flies
+// without hitting anything
+static std::vector<Vector2> OpenPositions(const LevelManager& level, size_t count, uint32_t seed) {
+    std::vector<Vector2> positions;
+    Rectangle active = level.GetActiveBounds();
+    float size = (float)level.GetTileSize();
+    std::mt19937 rng(seed);
+    int attempts = 0;
+    while (positions.size() < count && attempts++ < 1000000) {
+        int x = (int)(active.x / size) + (int)(rng() % (uint32_t)(active.width / size));
+        int y = (int)(active.y / size) + (int)(rng() % (uint32_t)(active.height / size));
+        const Tile* tile = level.GetTile(x, y);
+        if (tile && tile->type == TileType::EMPTY) {
+            positions.push_back({x * size + size / 2, y * size + size / 2});
+        }
+    }
+    return positions;
+}
+
+static void MapBenchmarks(BenchRunner& runner, int size) {
+    std::string suffix = "/" + std::to_string(size) + "x" + std::to_string(size);
+    GeneratedLevel generated = GenerateLevel(size, size, 1, 0.3f);
+    LevelManager level;
+
+    runner.Run("LoadLevel(memory)" + suffix, [&]() {
+        LoadGenerated(level, generated);
+        sink = sink + level.GetRemainingDestructibles();
+    });
+
+    std::string path = (std::filesystem::temp_directory_path() / ("bomber_bench_" + std::to_string(size) + ".bbl")).string();
+    if (runner.Wants("LoadLevel(file)" + suffix) && WriteLevel(generated, path)) {
+        runner.Run("LoadLevel(file)" + suffix, [&]() {
+            level.LoadLevel(path);
+            sink = sink + level.GetRemainingDestructibles();
+        });
+        level.LoadLevel(generated.header, generated.tiles.data());
+        std::filesystem::remove(path);
+    }
+
+    LoadGenerated(level, generated);
+    std::vector<Vector2> probes = OpenPositions(level, 1024, 2);
+    // Half of them pushed into a neighbouring cell so some probes collide
+    for (size_t i = 0; i < probes.size(); i += 2) {
+        probes[i].x += level.GetTileSize() / 2.0f;
+    }
+    size_t probe = 0;
+    runner.Run("CheckCollisionWithObstacles" + suffix, [&]() {
+        sink = sink + level.CheckCollisionWithObstacles(probes[probe++ % probes.size()]);
+    });
+
+    runner.Run("AreAllDestructiblesDestroyed" + suffix, [&]() {
+        sink = sink + level.AreAllDestructiblesDestroyed();
+    });
+}
+
+static void BulletBenchmarks(BenchRunner& runner, size_t count) {
+    std::string suffix = "/" + std::to_string(count);
+    const float dt = SIM_TIMESTEP;
+
+    // Bounds far away so no bullet ever leaves and the count stays fixed
+    BulletPool pool(count);
+    for (size_t i = 0; i < count; i++) {
+        float angle = i * 0.618f;
+        pool.Spawn({0, 0}, {std::cos(angle), std::sin(angle)}, i % 4 == 0);
+    }
+    Rectangle everywhere = {-1e9f, -1e9f, 2e9f, 2e9f};
+    runner.Run("BulletPool::Update" + suffix, [&]() {
+        pool.Update(dt, everywhere);
+        sink = sink + pool.Size();
+    });
+
+    // Bullets in open cells, just having moved a step; none of them hit,
+    // so every call does the same work
+    LevelManager level;
+    level.SetBulletCapacity(count);
+    GeneratedLevel generated = GenerateLevel(256, 256, 3, 0.3f);
+    LoadGenerated(level, generated);
+    BulletPool& bullets = level.GetBullets();
+    for (const Vector2& position : OpenPositions(level, count, 4)) {
+        bullets.Spawn(position, {0, 0}, false);
+    }
+    runner.Run("CheckBulletCollisions" + suffix, [&]() {
+        level.CheckBulletCollisions();
+        sink = sink + bullets.Size();
+    });
+}
+
+static void AnimationBenchmarks(BenchRunner& runner, int count) {
+    std::string suffix = "/" + std::to_string(count);
+
+    // Everything destructible, so there is a tile for every animation
+    LevelManager level;
+    GeneratedLevel generated = GenerateLevel(256, 256, 5, 1.0f);
+    LoadGenerated(level, generated);
+    int started = 0;
+    for (int y = 0; y < level.GetHeight() && started < count; y++) {
+        for (int x = 0; x < level.GetWidth() && started < count; x++) {
+            const Tile* tile = level.GetTile(x, y);
+            if (tile && tile->type == TileType::DESTRUCTIBLE) {
+                level.StartTileAnimation(x, y);
+                started++;
+            }
+        }
+    }
+
+    // dt 0 keeps every animation running, so each call does the same work
+    runner.Run("UpdateTileAnimations" + suffix, [&]() {
+        level.UpdateTileAnimations(0.0f);
+        sink = sink + level.GetRemainingDestructibles();
+    });
+}
+
+static void EntityBenchmarks(BenchRunner& runner, int count) {
+    std::string suffix = "/" + std::to_string(count) + " tanks";
+
+    // Tanks all over the resident area driving and firing in random
+    // directions. Nobody can die, so the work stays about the same.
+    LevelManager level;
+    level.SetBulletCapacity(4096);
+    GeneratedLevel generated = GenerateLevel(256, 256, 7, 0.1f);
+    LoadGenerated(level, generated);
+    EntityStore& entities = level.GetEntities();
+    entities.Healths().Find(level.GetPlayer().index)->hitPoints = INT32_MAX;
+
+    static const Vector2 directions[] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    std::mt19937 rng(8);
+    for (const Vector2& position : OpenPositions(level, count, 9)) {
+        Entity tank = level.SpawnTank(position, rng() % 2 ? TEAM_ENEMY : TEAM_NEUTRAL, INT32_MAX);
+        entities.Velocities().Find(tank.index)->move = directions[rng() % 4];
+    }
+
+    Snapshot start;
+    level.SaveSnapshot(start);
+    ComponentArray<Weapon>& weapons = entities.Weapons();
+    runner.Run("LevelManager::Update" + suffix, [&]() {
+        // Rewind before the time limit stops the level
+        if (level.GetTimeRemaining() < 1.0f) {
+            level.RestoreSnapshot(start);
+        }
+        for (size_t i = 0; i < weapons.Size(); i++) {
+            weapons[i].trigger = true;
+        }
+        level.Update({{0, 0}, false}, SIM_TIMESTEP);
+        sink = sink + level.GetBullets().Size();
+    });
+}
+
+static void BroadphaseBenchmarks(BenchRunner& runner, int count) {
+    std::string suffix = "/" + std::to_string(count) + " bodies";
+
+    // Tank sized bodies spread over a full resident window, nudged every
+    // call so each rebuild sees new positions
+    const float extent = (2 * STREAM_RADIUS + 1) * CHUNK_SIZE * 40.0f;
+    std::mt19937 rng(12);
+    std::uniform_real_distribution<float> coordinate(0.0f, extent);
+    std::vector<Rectangle> bodies;
+    for (int i = 0; i < count; i++) {
+        bodies.push_back({coordinate(rng), coordinate(rng), 30, 30});
+    }
+
+    SpatialHash hash;
+    int frame = 0;
+    runner.Run("SpatialHash pairs" + suffix, [&]() {
+        float nudge = (frame++ % 2) ? 1.5f : -1.5f;
+        hash.Clear();
+        for (int i = 0; i < count; i++) {
+            bodies[i].x += nudge;
+            hash.Insert(i, bodies[i]);
+        }
+        hash.Build();
+        int overlaps = 0;
+        hash.ForEachPair([&](uint32_t a, uint32_t b) {
+            overlaps += CheckCollisionRecs(bodies[a], bodies[b]);
+        });
+        sink = sink + overlaps;
+    });
+
+    // What the broadphase replaces
+    runner.Run("Pairwise pairs" + suffix, [&]() {
+        int overlaps = 0;
+        for (int a = 0; a < count; a++) {
+            for (int b = a + 1; b < count; b++) {
+                overlaps += CheckCollisionRecs(bodies[a], bodies[b]);
+            }
+        }
+        sink = sink + overlaps;
+    });
+}
+
+static void FlowFieldBenchmarks(BenchRunner& runner) {
+    // The size of a full resident window, a quarter of it walls
+    const int size = (2 * STREAM_RADIUS + 1) * CHUNK_SIZE;
+    std::mt19937 rng(10);
+    std::vector<uint8_t> open((size_t)size * size);
+    FlowField field;
+    field.Reset(0, 0, size, size);
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            // Keep the cells the target moves between open
+            open[y * size + x] = rng() % 4 != 0 || (y == size / 2 && (x == size / 2 || x == size / 2 + 1));
+            field.SetPassable(x, y, open[y * size + x]);
+        }
+    }
+    field.SetTarget(size / 2, size / 2);
+
+    std::string suffix = "/" + std::to_string(size) + "x" + std::to_string(size);
+    runner.Run("FlowField::Rebuild" + suffix, [&]() {
+        field.Rebuild();
+        sink = sink + field.GetDistance(0, 0);
+    });
+
+    // What a tick usually repairs: the target steps to the next cell, or
+    // a wall near it opens up (and closes again so the work stays the same)
+    field.Rebuild();
+    int step = 0;
+    runner.Run("FlowField::Update(target moved)" + suffix, [&]() {
+        int x = size / 2 + (step++ % 2);
+        field.SetTarget(x, size / 2);
+        field.Update();
+        sink = sink + field.GetLastRepairCount();
+    });
+    field.SetTarget(size / 2, size / 2);
+    field.Rebuild();
+    std::vector<int> walls;
+    for (int i = 0; i < size * size; i++) {
+        if (!open[i] && std::abs(i % size - size / 2) < 8 && std::abs(i / size - size / 2) < 8) {
+            walls.push_back(i);
+        }
+    }
+    size_t wall = 0;
+    runner.Run("FlowField::Update(tile opened)" + suffix, [&]() {
+        int cell = walls[wall++ % walls.size()];
+        field.SetPassable(cell % size, cell / size, true);
+        field.Update();
+        sink = sink + field.GetLastRepairCount();
+        field.SetPassable(cell % size, cell / size, false);
+        field.Update();
+    });
+}
+
+static void EnemyBenchmarks(BenchRunner& runner, int count) {
+    std::string suffix = "/" + std::to_string(count) + " enemies";
+
+    // Enemies chasing a player that walks back and forth, so the field is
+    // repaired every few ticks. The player can't die and doesn't shoot
+    // back, so the number of enemies stays the same.
+    LevelManager level;
+    level.SetBulletCapacity(4096);
+    GeneratedLevel generated = GenerateLevel(256, 256, 7, 0.1f);
+    LoadGenerated(level, generated);
+    level.GetEntities().Healths().Find(level.GetPlayer().index)->hitPoints = INT32_MAX;
+    for (const Vector2& position : OpenPositions(level, count, 11)) {
+        level.SpawnEnemy(position);
+    }
+
+    Snapshot start;
+    level.SaveSnapshot(start);
+    int tick = 0;
+    runner.Run("LevelManager::Update" + suffix, [&]() {
+        if (level.GetTimeRemaining() < 1.0f) {
+            level.RestoreSnapshot(start);
+        }
+        SimInput input = {{(tick++ / 60) % 2 ? -1.0f : 1.0f, 0}, false};
+        level.Update(input, SIM_TIMESTEP);
+        sink = sink + level.GetBullets().Size();
+    });
+}
+
+static void SnapshotBenchmarks(BenchRunner& runner) {
+    // Random play for a while so the snapshot has bullets, explosions and
+    // destroyed tiles in it
+    LevelManager level;
+    GeneratedLevel generated = GenerateLevel(20, 15, 6, 0.3f);
+    LoadGenerated(level, generated);
+    static const Vector2 directions[] = {{0, 0}, {1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    std::mt19937 rng(1);
+    for (int tick = 0; tick < 1200 && level.GetStatus() == LevelStatus::RUNNING; tick++) {
+        SimInput input = {directions[(tick / 30 + rng() % 2) % 5], tick % 30 == 0};
+        level.Update(input, SIM_TIMESTEP);
+    }
+
+    Snapshot snapshot;
+    level.SaveSnapshot(snapshot);
+
+    // Restoring and replaying the same ticks has to land on the same state
+    SimInput input = {{1, 0}, true};
+    for (int tick = 0; tick < 8; tick++) level.Update(input, SIM_TIMESTEP);
+    uint64_t expected = level.GetStateHash();
+    level.RestoreSnapshot(snapshot);
+    for (int tick = 0; tick < 8; tick++) level.Update(input, SIM_TIMESTEP);
+    if (level.GetStateHash() != expected) {
+        std::cout << "rollback diverged, skipping snapshot benchmarks" << std::endl;
+        return;
+    }
+    level.RestoreSnapshot(snapshot);
+
+    runner.Run("SaveSnapshot/" + std::to_string(snapshot.Size()) + "B", [&]() {
+        level.SaveSnapshot(snapshot);
+        sink = sink + snapshot.Size();
+    });
+    runner.Run("RestoreSnapshot/" + std::to_string(snapshot.Size()) + "B", [&]() {
+        level.RestoreSnapshot(snapshot);
+        sink = sink + level.GetRemainingDestructibles();
+    });
+    runner.Run("Rollback/8 ticks", [&]() {
+        level.RestoreSnapshot(snapshot);
+        SimInput step = {{1, 0}, false};
+        for (int tick = 0; tick < 8; tick++) level.Update(step, SIM_TIMESTEP);
+        sink = sink + level.GetBullets().Size();
+    });
+}
+
+int main(int argc, char** argv) {
+    std::string filter;
+    std::string csvPath;
+    std::string baselinePath;
+    int samples = 15;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-f" && hasValue) {
+            filter = argv[++i];
+        } else if (arg == "-n" && hasValue) {
+            samples = std::atoi(argv[++i]);
+        } else if (arg == "-o" && hasValue) {
+            csvPath = argv[++i];
+        } else if (arg == "-b" && hasValue) {
+            baselinePath = argv[++i];
+        } else {
+            samples = 0;
+            break;
+        }
+    }
+    if (samples <= 0) {
+        std::cerr << "usage: bomber_bench [-f filter] [-n samples] [-o results.csv] [-b baseline.csv]" << std::endl;
+        return 1;
+    }
+
+    BenchRunner runner(filter, samples);
+    for (int size : {20, 256, 1024, 4096}) {
+        MapBenchmarks(runner, size);
+    }
+    for (size_t count : {32, 256, 4096}) {
+        BulletBenchmarks(runner, count);
+    }
+    for (int count : {16, 256, 4096}) {
+        AnimationBenchmarks(runner, count);
+    }
+    for (int count : {16, 256, 1024}) {
+        EntityBenchmarks(runner, count);
+    }
+    for (int count : {256, 1024, 4096}) {
+        BroadphaseBenchmarks(runner, count);
+    }
+    FlowFieldBenchmarks(runner);
+    for (int count : {1, 100, 500}) {
+        EnemyBenchmarks(runner, count);
+    }
+    SnapshotBenchmarks(runner);
+
+    if (!csvPath.empty() && !SaveResults(runner.GetResults(), csvPath)) {
+        std::cerr << "cannot write " << csvPath << std::endl;
+        return 1;
+    }
+    if (!baselinePath.empty()) {
+        CompareWithBaseline(runner.GetResults(), baselinePath);
+    }
+    return 0;
+}
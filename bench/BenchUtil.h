@@ -0,0 +1,160 @@
+#ifndef BENCHUTIL_H
+#define BENCHUTIL_H
+
+// Helpers shared by bomber_bench and bomber_stress: generated levels of any
+// size and robust statistics over timing samples.
+
+#include "LevelFormat.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+struct GeneratedLevel {
+    LevelHeader header;
+    std::vector<Tile> tiles;
+};
+
+// What GenerateLevel puts on the map. Open cells are filled at random with
+// the given fractions of destructibles, barrels and power-ups.
+struct LevelRecipe {
+    int width;
+    int height;
+    uint32_t seed;
+    bool pillars;        // a wall on every other cell both ways
+    float destructibles;
+    float barrels;
+    float powerUps;
+};
+
+// One row of the map. Rows are seeded separately, so huge levels can be
+// written out row by row and still come out the same as GenerateLevel.
+// Spawn is the top left corner, exit the bottom right, both kept clear.
+inline uint32_t GenerateRow(const LevelRecipe& recipe, int y, Tile* row) {
+    std::mt19937 rng(recipe.seed ^ (uint32_t)(y * 2654435761u));
+    uint32_t destructibles = 0;
+    for (int x = 0; x < recipe.width; x++) {
+        Tile& tile = row[x];
+        tile = Tile{TileType::EMPTY, 0};
+        bool border = x == 0 || y == 0 || x == recipe.width - 1 || y == recipe.height - 1;
+        bool nearSpawn = x <= 2 && y <= 2;
+        bool nearExit = x >= recipe.width - 3 && y >= recipe.height - 3;
+        if (border || (recipe.pillars && x % 2 == 0 && y % 2 == 0)) {
+            tile.type = TileType::WALL;
+        } else if (x == recipe.width - 2 && y == recipe.height - 2) {
+            tile.type = TileType::EXIT_POINT;
+        } else if (!nearSpawn && !nearExit) {
+            float roll = (rng() & 0xffffff) / (float)0x1000000;
+            if (roll < recipe.destructibles) {
+                tile.type = TileType::DESTRUCTIBLE;
+                destructibles++;
+            } else if (roll < recipe.destructibles + recipe.barrels) {
+                tile.type = TileType::BARREL;
+            } else if (roll < recipe.destructibles + recipe.barrels + recipe.powerUps) {
+                tile.type = TileType::POWER_UP;
+            }
+        }
+    }
+    return destructibles;
+}
+
+inline LevelHeader MakeHeader(const LevelRecipe& recipe, uint32_t destructibles) {
+    LevelHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, LEVEL_MAGIC, sizeof(LEVEL_MAGIC));
+    header.version = LEVEL_VERSION;
+    header.headerSize = sizeof(LevelHeader);
+    header.width = (uint32_t)recipe.width;
+    header.height = (uint32_t)recipe.height;
+    header.spawnX = 1;
+    header.spawnY = 1;
+    header.exitX = (uint32_t)recipe.width - 2;
+    header.exitY = (uint32_t)recipe.height - 2;
+    header.destructibles = destructibles;
+    return header;
+}
+
+inline GeneratedLevel GenerateLevel(const LevelRecipe& recipe) {
+    GeneratedLevel level;
+    level.tiles.resize((size_t)recipe.width * recipe.height);
+    uint32_t destructibles = 0;
+    for (int y = 0; y < recipe.height; y++) {
+        destructibles += GenerateRow(recipe, y, &level.tiles[(size_t)y * recipe.width]);
+    }
+    level.header = MakeHeader(recipe, destructibles);
+    return level;
+}
+
+// Classic layout: pillars, random destructibles and nothing else
+inline GeneratedLevel GenerateLevel(int width, int height, uint32_t seed, float destructibleRatio) {
+    return GenerateLevel(LevelRecipe{width, height, seed, true, destructibleRatio, 0.0f, 0.0f});
+}
+
+inline bool WriteLevel(const GeneratedLevel& level, const std::string& path) {
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(&level.header), sizeof(LevelHeader));
+    out.write(reinterpret_cast<const char*>(level.tiles.data()), level.tiles.size() * sizeof(Tile));
+    return (bool)out;
+}
+
+// Same file as WriteLevel(GenerateLevel(recipe)) without ever holding the
+// whole map in memory. The header is written last, once the count is known.
+inline bool WriteLevel(const LevelRecipe& recipe, const std::string& path) {
+    std::ofstream out(path, std::ios::binary);
+    LevelHeader header = MakeHeader(recipe, 0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(LevelHeader));
+
+    std::vector<Tile> row(recipe.width);
+    uint32_t destructibles = 0;
+    for (int y = 0; y < recipe.height; y++) {
+        destructibles += GenerateRow(recipe, y, row.data());
+        out.write(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(Tile));
+    }
+
+    header.destructibles = destructibles;
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(LevelHeader));
+    return (bool)out;
+}
+
+// Median and median absolute deviation ignore the odd sample that got
+// preempted, which is what makes two runs comparable
+struct SampleStats {
+    double median;
+    double min;
+    double max;
+    double mad;
+    double p99;
+};
+
+inline double Percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) return 0;
+    size_t index = (size_t)std::ceil(fraction * sorted.size());
+    return sorted[std::min(sorted.size() - 1, index > 0 ? index - 1 : 0)];
+}
+
+inline SampleStats ComputeStats(std::vector<double> samples) {
+    SampleStats stats = {0, 0, 0, 0, 0};
+    if (samples.empty()) return stats;
+
+    std::sort(samples.begin(), samples.end());
+    stats.min = samples.front();
+    stats.max = samples.back();
+    stats.median = Percentile(samples, 0.5);
+    stats.p99 = Percentile(samples, 0.99);
+
+    std::vector<double> deviations;
+    deviations.reserve(samples.size());
+    for (double sample : samples) {
+        deviations.push_back(std::fabs(sample - stats.median));
+    }
+    std::sort(deviations.begin(), deviations.end());
+    stats.mad = Percentile(deviations, 0.5);
+    return stats;
+}
+
+#endif
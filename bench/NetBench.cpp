@@ -0,0 +1,290 @@
+// bomber_netbench: a MatchServer and bot clients talking over loopback,
+// through relays that drop and delay datagrams.
+//
+//   bomber_netbench [-c <clients>] [-t <seconds>] [-s <seed>]
+//
+// Runs the same match at 0%, 5% and 20% loss, each way, with 30-50 ms of
+// delay each way. Time is virtual: every step is one SIM_TIMESTEP for the
+// server, the clients and the relays alike, so a run takes as long as the
+// simulation does and comes out the same every time for a given seed.
+//
+// Reports the server's traffic per client, the average snapshot size, how
+// many snapshots went out full (no baseline) or as deltas, the age of the
+// newest snapshot when it arrives (p50/p99), the input round trip and the
+// snapshots clients had to reject. Loss is then switched off for two
+// seconds and every client's tile log has to end up the same as the
+// server's was at the tick of the client's newest snapshot.
+
+#include "BenchUtil.h"
+#include "LevelManager.h"
+#include "MatchClient.h"
+#include "MatchServer.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Stands in for the network between one client and the server. Has a
+// loopback socket of its own, so the server sees one address per client,
+// and forwards whatever arrives to the other side once its delay is up.
+class LossyRelay {
+private:
+    struct Packet {
+        double due;
+        bool toServer;
+        std::vector<unsigned char> data;
+    };
+
+    NetSocket socket;
+    NetAddress server;
+    NetAddress client;
+    bool knowsClient;
+    std::mt19937 rng;
+    std::vector<Packet> inFlight;
+    unsigned char buffer[2048];
+
+public:
+    float loss;
+    double delay;
+    double jitter;
+    uint64_t snapshotBytes;
+    uint32_t snapshots;
+
+    LossyRelay(uint32_t seed)
+        : server{0, 0}, client{0, 0}, knowsClient(false), rng(seed), loss(0), delay(0.030), jitter(0.020),
+          snapshotBytes(0), snapshots(0) {}
+
+    bool Open(uint16_t serverPort, std::string& error) {
+        return ParseAddress("127.0.0.1", serverPort, server, error) && socket.Open(0, error);
+    }
+
+    uint16_t GetPort() const {
+        return socket.GetPort();
+    }
+
+    // Picks up what both sides sent and delivers what is due by now.
+    // Jitter can reorder datagrams, as on a real network.
+    void Pump(double now) {
+        NetAddress from = {};
+        size_t size = 0;
+        while ((size = socket.Receive(from, buffer, sizeof(buffer))) > 0) {
+            bool toServer = from != server;
+            if (toServer) {
+                client = from;
+                knowsClient = true;
+            } else if (buffer[0] == (unsigned char)NetMessage::SNAPSHOT) {
+                snapshotBytes += size;
+                snapshots++;
+            }
+            if (std::uniform_real_distribution<float>(0, 1)(rng) < loss) continue;
+            double due = now + delay + std::uniform_real_distribution<double>(0, jitter)(rng);
+            inFlight.push_back(Packet{due, toServer, std::vector<unsigned char>(buffer, buffer + size)});
+        }
+
+        std::stable_sort(inFlight.begin(), inFlight.end(),
+                         [](const Packet& a, const Packet& b) { return a.due < b.due; });
+        size_t sent = 0;
+        while (sent < inFlight.size() && inFlight[sent].due <= now) {
+            const Packet& packet = inFlight[sent++];
+            if (packet.toServer) {
+                socket.Send(server, packet.data.data(), packet.data.size());
+            } else if (knowsClient) {
+                socket.Send(client, packet.data.data(), packet.data.size());
+            }
+        }
+        inFlight.erase(inFlight.begin(), inFlight.begin() + sent);
+    }
+};
+
+struct Bot {
+    MatchClient client;
+    LevelManager view;
+    std::mt19937 rng;
+    SimInput input;
+    uint32_t shownTick;
+    uint32_t shownAck;
+
+    Bot(uint32_t seed) : rng(seed), input{{0, 0}, false}, shownTick(0), shownAck(0) {}
+};
+
+struct NetResult {
+    double downPerClient;  // bytes per second
+    double upPerClient;
+    double averageSnapshot;
+    uint32_t fullSnapshots;
+    uint32_t deltaSnapshots;
+    double latencyP50;     // seconds
+    double latencyP99;
+    double inputLatency;
+    uint32_t rejected;
+    int clientsInSync;
+};
+
+// A new direction every quarter second, sometimes firing
+static SimInput RandomInput(std::mt19937& rng, long long step, SimInput current) {
+    if (step % 30 != 0) {
+        current.shoot = false;
+        return current;
+    }
+
+    static const Vector2 directions[] = {{0, 0}, {1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    current.move = directions[rng() % 5];
+    current.shoot = rng() % 4 == 0;
+    return current;
+}
+
+static bool RunMatch(const std::string& levelPath, int clientCount, double seconds, float loss, uint32_t seed,
+                     NetResult& result) {
+    MatchServer server;
+    std::string error;
+    if (!server.Start(levelPath, 0, error)) {
+        std::cerr << error << std::endl;
+        return false;
+    }
+
+    std::vector<std::unique_ptr<LossyRelay>> relays;
+    std::vector<std::unique_ptr<Bot>> bots;
+    for (int i = 0; i < clientCount; i++) {
+        relays.push_back(std::make_unique<LossyRelay>(seed * 31 + i));
+        bots.push_back(std::make_unique<Bot>(seed * 17 + i));
+        if (!relays[i]->Open(server.GetPort(), error) ||
+            !bots[i]->client.Connect("127.0.0.1:" + std::to_string(relays[i]->GetPort()), error)) {
+            std::cerr << error << std::endl;
+            return false;
+        }
+        relays[i]->loss = loss;
+    }
+
+    // Tile log length at every snapshot tick, to check the clients against
+    std::unordered_map<uint32_t, size_t> tileLogAt;
+    std::vector<double> snapshotAges;
+    std::vector<double> inputLatencies;
+    const long long steps = (long long)(seconds / SIM_TIMESTEP);
+    const long long drainSteps = (long long)(2.0 / SIM_TIMESTEP);
+    double now = 0;
+
+    for (long long step = 0; step < steps + drainSteps; step++) {
+        if (step == steps) {
+            for (auto& relay : relays) relay->loss = 0;
+        }
+        now += SIM_TIMESTEP;
+
+        for (auto& bot : bots) {
+            bot->client.Update(SIM_TIMESTEP);
+            if (bot->client.GetState() != ClientState::CONNECTED) continue;
+
+            bot->input = RandomInput(bot->rng, step, bot->input);
+            bot->client.SendInput(bot->input);
+            if (!bot->client.ApplyTo(bot->view)) return false;
+            if (bot->client.HasSnapshot()) {
+                bot->view.UpdateRemoteView(SIM_TIMESTEP);
+            }
+
+            if (step < steps && bot->client.GetLatestTick() != bot->shownTick) {
+                bot->shownTick = bot->client.GetLatestTick();
+                snapshotAges.push_back((server.GetTick() - bot->shownTick) * SIM_TIMESTEP);
+            }
+            if (step < steps && bot->client.GetInputAck() != bot->shownAck) {
+                bot->shownAck = bot->client.GetInputAck();
+                inputLatencies.push_back(bot->client.GetInputLatency());
+            }
+        }
+
+        for (auto& relay : relays) relay->Pump(now);
+        server.Tick();
+        if (server.GetTick() % NET_SNAPSHOT_INTERVAL == 0) {
+            tileLogAt[server.GetTick()] = server.GetTileLogSize();
+        }
+        for (auto& relay : relays) relay->Pump(now);
+    }
+
+    uint64_t snapshotBytes = 0;
+    uint32_t snapshots = 0;
+    for (auto& relay : relays) {
+        snapshotBytes += relay->snapshotBytes;
+        snapshots += relay->snapshots;
+    }
+    double total = now * clientCount;
+    result.downPerClient = server.GetBytesSent() / total;
+    result.upPerClient = server.GetBytesReceived() / total;
+    result.averageSnapshot = snapshots > 0 ? (double)snapshotBytes / snapshots : 0;
+    result.fullSnapshots = server.GetFullSnapshotsSent();
+    result.deltaSnapshots = server.GetSnapshotsSent() - server.GetFullSnapshotsSent();
+
+    std::sort(snapshotAges.begin(), snapshotAges.end());
+    result.latencyP50 = Percentile(snapshotAges, 0.5);
+    result.latencyP99 = Percentile(snapshotAges, 0.99);
+    result.inputLatency = ComputeStats(inputLatencies).median;
+
+    result.rejected = 0;
+    result.clientsInSync = 0;
+    for (auto& bot : bots) {
+        result.rejected += bot->client.GetSnapshotsRejected();
+        auto expected = tileLogAt.find(bot->client.GetLatestTick());
+        if (expected != tileLogAt.end() && expected->second == bot->client.GetTileLogSize()) {
+            result.clientsInSync++;
+        }
+        bot->client.Disconnect();
+    }
+    server.Stop();
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int clientCount = 4;
+    double seconds = 60;
+    uint32_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-c" && i + 1 < argc) {
+            clientCount = std::atoi(argv[++i]);
+        } else if (arg == "-t" && i + 1 < argc) {
+            seconds = std::atof(argv[++i]);
+        } else if (arg == "-s" && i + 1 < argc) {
+            seed = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        } else {
+            clientCount = 0;
+            break;
+        }
+    }
+    if (clientCount <= 0 || clientCount > NET_MAX_CLIENTS || seconds <= 0) {
+        std::cerr << "usage: bomber_netbench [-c clients (1-" << NET_MAX_CLIENTS << ")] [-t seconds] [-s seed]"
+                  << std::endl;
+        return 1;
+    }
+
+    // About the size of the streaming window, with plenty to blow up
+    const LevelRecipe recipe = {64, 64, seed, true, 0.35f, 0.03f, 0.02f};
+    std::string levelPath = (std::filesystem::temp_directory_path() / "bomber_netbench.bbl").string();
+    if (!WriteLevel(GenerateLevel(recipe), levelPath)) {
+        std::cerr << "cannot write " << levelPath << std::endl;
+        return 1;
+    }
+
+    std::cout << clientCount << " clients, " << seconds << " s per run, seed " << seed << std::endl;
+    bool synced = true;
+    for (float loss : {0.0f, 0.05f, 0.20f}) {
+        NetResult result;
+        if (!RunMatch(levelPath, clientCount, seconds, loss, seed, result)) return 1;
+
+        char line[240];
+        std::snprintf(line, sizeof(line),
+                      "loss %2d%%  down %6.0f B/s  up %5.0f B/s per client  snapshot %5.1f B (%u full, %u delta)  "
+                      "age p50 %3.0f ms p99 %3.0f ms  input %3.0f ms  rejected %u  in sync %d/%d",
+                      (int)(loss * 100 + 0.5f), result.downPerClient, result.upPerClient, result.averageSnapshot,
+                      result.fullSnapshots, result.deltaSnapshots, result.latencyP50 * 1000, result.latencyP99 * 1000,
+                      result.inputLatency * 1000, result.rejected, result.clientsInSync, clientCount);
+        std::cout << line << std::endl;
+        synced = synced && result.clientsInSync == clientCount;
+    }
+
+    std::filesystem::remove(levelPath);
+    return synced ? 0 : 2;
+}
@@ -0,0 +1,31 @@
+#include "PeakMemory.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+
+uint64_t GetPeakMemoryKb() {
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return counters.PeakWorkingSetSize / 1024;
+}
+
+#elif defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+
+uint64_t GetPeakMemoryKb() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+    return (uint64_t)usage.ru_maxrss / 1024;  // bytes on macOS
+#else
+    return (uint64_t)usage.ru_maxrss;
+#endif
+}
+
+#else
+uint64_t GetPeakMemoryKb() {
+    return 0;
+}
+#endif
@@ -0,0 +1,11 @@
+#ifndef PEAKMEMORY_H
+#define PEAKMEMORY_H
+
+#include <cstdint>
+
+// Largest resident set the process has had so far, in KB. 0 where the
+// platform has no way to ask. Kept out of the other bench sources so
+// windows.h never meets raylib.h.
+uint64_t GetPeakMemoryKb();
+
+#endif
@@ -0,0 +1,481 @@
+// bomber_stress: end-to-end stress scenarios, run headless through LevelManager.
+//
+//   bomber_stress [--baseline=<file>] [--tolerance=<fraction>] [--record=<file>] [scenario...]
+//
+// Scenarios (all of them when none is named):
+//   huge_map           4096x4096 level, the player teleported around it every
+//                      quarter second so chunks stream in and out all the time
+//   bullet_storm       about 4000 bullets in flight on an open map
+//   chain_destruction  power-up bullets blowing up a field of blocks and
+//                      power-ups, hundreds of explosions at once
+//   barrel_chain       a map half full of barrels set off in a few places,
+//                      chain reactions through thousands of them, 32 matches
+//   long_session       back-to-back random matches, a million ticks in all
+//
+// Each one reports ticks/s, the 99th percentile tick time and the peak
+// memory of the process. With --baseline the numbers are checked against
+// the stored ones: fewer ticks/s, or a higher p99 or peak, by more than the
+// tolerance (default 0.25) is a regression and the exit code is 2.
+// --record writes the numbers of this run into a baseline file.
+//
+// Peak memory is for the whole process, so it is only checked and recorded
+// when a single scenario runs. CTest runs each scenario on its own.
+
+#include "BenchUtil.h"
+#include "LevelFile.h"
+#include "LevelManager.h"
+#include "PeakMemory.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct StressResult {
+    long long ticks;
+    double seconds;
+    double ticksPerSecond;
+    double p99Ms;
+    uint64_t peakKb;
+};
+
+// Times LevelManager::Update only, whatever a scenario does between ticks
+// to set up the next one isn't counted. Tick times go into log-spaced
+// buckets, about 1% wide, so a million ticks cost no more memory than ten.
+class TickClock {
+private:
+    static constexpr double MIN_MS = 0.0001;
+    static constexpr int BUCKETS_PER_DOUBLING = 64;
+    static constexpr int BUCKET_COUNT = BUCKETS_PER_DOUBLING * 24;  // up to about 1.6 s
+    std::vector<long long> buckets = std::vector<long long>(BUCKET_COUNT, 0);
+    long long ticks = 0;
+    double total = 0;
+
+    // Upper edge of a bucket
+    static double BucketLimit(int bucket) {
+        return MIN_MS * std::exp2((bucket + 1) / (double)BUCKETS_PER_DOUBLING);
+    }
+
+public:
+    void Tick(LevelManager& level, const SimInput& input) {
+        auto start = std::chrono::steady_clock::now();
+        level.Update(input, SIM_TIMESTEP);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        int bucket = ms <= MIN_MS ? 0 : (int)(std::log2(ms / MIN_MS) * BUCKETS_PER_DOUBLING);
+        buckets[std::min(bucket, BUCKET_COUNT - 1)]++;
+        ticks++;
+        total += ms;
+    }
+
+    StressResult Finish() const {
+        StressResult result = {0, 0, 0, 0, 0};
+        result.ticks = ticks;
+        result.seconds = total / 1000.0;
+        result.ticksPerSecond = total > 0 ? ticks / result.seconds : 0;
+
+        // Bucket holding the 99th percentile tick
+        long long rank = (long long)std::ceil(ticks * 0.99);
+        long long seen = 0;
+        for (int bucket = 0; bucket < BUCKET_COUNT && ticks > 0; bucket++) {
+            seen += buckets[bucket];
+            if (seen >= rank) {
+                result.p99Ms = BucketLimit(bucket);
+                break;
+            }
+        }
+        result.peakKb = GetPeakMemoryKb();
+        return result;
+    }
+};
+
+// Same policy as bomber_batch: a new direction every quarter second,
+// sometimes firing
+static SimInput RandomInput(std::mt19937& rng, long long tick, SimInput current) {
+    if (tick % 30 != 0) {
+        current.shoot = false;
+        return current;
+    }
+
+    static const Vector2 directions[] = {{0, 0}, {1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    current.move = directions[rng() % 5];
+    current.shoot = rng() % 4 == 0;
+    return current;
+}
+
+static Vector2 CellCenter(int x, int y, int tileSize) {
+    return {(x + 0.5f) * tileSize, (y + 0.5f) * tileSize};
+}
+
+// Random empty cell of the whole level, looked up in the level data rather
+// than through LevelManager, which only sees resident chunks
+static Vector2 RandomOpenCell(std::mt19937& rng, const Tile* tiles, int width, int height, int tileSize) {
+    while (true) {
+        int x = 1 + (int)(rng() % (uint32_t)(width - 2));
+        int y = 1 + (int)(rng() % (uint32_t)(height - 2));
+        if (tiles[(size_t)y * width + x].type == TileType::EMPTY) {
+            return CellCenter(x, y, tileSize);
+        }
+    }
+}
+
+// Random empty cell near the player, where spawned bullets stay in play
+static bool RandomActiveCell(std::mt19937& rng, const LevelManager& level, Vector2& position) {
+    Rectangle active = level.GetActiveBounds();
+    int size = level.GetTileSize();
+    for (int attempt = 0; attempt < 64; attempt++) {
+        int x = (int)(active.x / size) + (int)(rng() % (uint32_t)(active.width / size));
+        int y = (int)(active.y / size) + (int)(rng() % (uint32_t)(active.height / size));
+        const Tile* tile = level.GetTile(x, y);
+        if (tile && tile->type == TileType::EMPTY) {
+            position = CellCenter(x, y, size);
+            return true;
+        }
+    }
+    return false;
+}
+
+static std::string TempLevelPath(const std::string& name) {
+    return (std::filesystem::temp_directory_path() / ("bomber_stress_" + name + ".bbl")).string();
+}
+
+static bool HugeMap(StressResult& result) {
+    const LevelRecipe recipe = {4096, 4096, 11, true, 0.3f, 0.0f, 0.02f};
+    const long long ticks = 400000;
+    const int teleportInterval = 30;
+
+    // Written out row by row and mapped, so the map itself never counts
+    // towards the peak, only what the simulation keeps resident
+    std::string path = TempLevelPath("huge_map");
+    if (!WriteLevel(recipe, path)) {
+        std::cerr << "cannot write " << path << std::endl;
+        return false;
+    }
+
+    LevelFile file;
+    std::string error;
+    LevelManager level;
+    if (!file.Open(path, error) || !level.LoadLevel(path)) {
+        std::cerr << (error.empty() ? "cannot load " + path : error) << std::endl;
+        std::filesystem::remove(path);
+        return false;
+    }
+
+    std::mt19937 rng(1);
+    SimInput input = {{0, 0}, false};
+    TickClock clock;
+    for (long long tick = 0; tick < ticks; tick++) {
+        // Longer than one match, start over whenever it ends
+        if (level.GetStatus() != LevelStatus::RUNNING) {
+            level.LoadLevel(path);
+        }
+        if (tick % teleportInterval == 0) {
+            level.TeleportEntity(level.GetPlayer(),
+                RandomOpenCell(rng, file.GetTiles(), recipe.width, recipe.height, level.GetTileSize()));
+        }
+        input = RandomInput(rng, tick, input);
+        clock.Tick(level, input);
+    }
+    result = clock.Finish();
+
+    file.Close();
+    std::filesystem::remove(path);
+    return true;
+}
+
+static bool BulletStorm(StressResult& result) {
+    const LevelRecipe recipe = {512, 512, 12, false, 0.02f, 0.0f, 0.0f};
+    const size_t capacity = 4096;
+    const int ticks = 6000;
+    const int spawnsPerTick = 48;
+
+    GeneratedLevel generated = GenerateLevel(recipe);
+    LevelManager level;
+    level.SetBulletCapacity(capacity);
+    level.LoadLevel(generated.header, generated.tiles.data());
+
+    // Away from the corner so the resident window is full
+    level.TeleportEntity(level.GetPlayer(),
+                         CellCenter(recipe.width / 2 + 1, recipe.height / 2 + 1, level.GetTileSize()));
+
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+    BulletPool& bullets = level.GetBullets();
+    TickClock clock;
+    for (int tick = 0; tick < ticks && level.GetStatus() == LevelStatus::RUNNING; tick++) {
+        for (int i = 0; i < spawnsPerTick && bullets.Size() < capacity; i++) {
+            Vector2 position;
+            if (!RandomActiveCell(rng, level, position)) break;
+            float a = angle(rng);
+            bullets.Spawn(position, {std::cos(a), std::sin(a)}, false);
+        }
+        clock.Tick(level, {{0, 0}, false});
+    }
+    result = clock.Finish();
+    return true;
+}
+
+static bool ChainDestruction(StressResult& result) {
+    const LevelRecipe recipe = {1024, 1024, 13, true, 0.65f, 0.0f, 0.15f};
+    const int ticks = 12000;
+    const int spawnsPerTick = 24;
+    // Long enough to flatten the area around the player, then a fresh one
+    const int teleportInterval = 300;
+
+    GeneratedLevel generated = GenerateLevel(recipe);
+    LevelManager level;
+    level.SetBulletCapacity(1024);
+    level.LoadLevel(generated.header, generated.tiles.data());
+
+    static const Vector2 directions[] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    std::mt19937 rng(3);
+    BulletPool& bullets = level.GetBullets();
+    TickClock clock;
+    for (int tick = 0; tick < ticks && level.GetStatus() == LevelStatus::RUNNING; tick++) {
+        if (tick % teleportInterval == 0) {
+            level.TeleportEntity(level.GetPlayer(),
+                RandomOpenCell(rng, generated.tiles.data(), recipe.width, recipe.height, level.GetTileSize()));
+        }
+        for (int i = 0; i < spawnsPerTick; i++) {
+            Vector2 position;
+            if (!RandomActiveCell(rng, level, position)) break;
+            bullets.Spawn(position, directions[rng() % 4], true);
+        }
+        clock.Tick(level, {{0, 0}, false});
+    }
+    result = clock.Finish();
+    return true;
+}
+
+static bool BarrelChain(StressResult& result) {
+    const LevelRecipe recipe = {512, 512, 15, false, 0.01f, 0.5f, 0.0f};
+    const int ticks = 12000;  // inside the time limit
+    // The same match over again on a fresh load, one alone is over in
+    // about 30 ms, too short to time reliably
+    const int matches = 32;
+    const int ignitions = 8;
+    // About as long as a chain takes to burn through the resident area
+    const int teleportInterval = 2400;
+
+    GeneratedLevel generated = GenerateLevel(recipe);
+    LevelManager level;
+    int size = level.GetTileSize();
+    TickClock clock;
+    for (int match = 0; match < matches; match++) {
+        level.LoadLevel(generated.header, generated.tiles.data());
+        std::mt19937 rng(5 + match);
+        for (int tick = 0; tick < ticks && level.GetStatus() == LevelStatus::RUNNING; tick++) {
+            if (tick % teleportInterval == 0) {
+                level.TeleportEntity(level.GetPlayer(),
+                    RandomOpenCell(rng, generated.tiles.data(), recipe.width, recipe.height, size));
+            }
+            // The chunks around the new spot are loaded by the tick in between
+            if (tick % teleportInterval == 1) {
+                Rectangle active = level.GetActiveBounds();
+                for (int i = 0; i < ignitions; i++) {
+                    level.StartTileAnimation((int)(active.x / size) + (int)(rng() % (uint32_t)(active.width / size)),
+                                             (int)(active.y / size) + (int)(rng() % (uint32_t)(active.height / size)));
+                }
+            }
+            clock.Tick(level, {{0, 0}, false});
+        }
+    }
+    result = clock.Finish();
+    return true;
+}
+
+static bool LongSession(StressResult& result) {
+    const LevelRecipe recipe = {256, 256, 14, true, 0.3f, 0.02f, 0.02f};
+    const long long ticks = 1000000;
+
+    GeneratedLevel generated = GenerateLevel(recipe);
+    LevelManager level;
+    std::mt19937 rng(4);
+    SimInput input = {{0, 0}, false};
+    long long matchTick = 0;
+    TickClock clock;
+    for (long long tick = 0; tick < ticks; tick++) {
+        // A match ends when the player wins, dies or runs out of time,
+        // the next one starts on the same LevelManager
+        if (tick == 0 || level.GetStatus() != LevelStatus::RUNNING) {
+            level.LoadLevel(generated.header, generated.tiles.data());
+            matchTick = 0;
+        }
+        input = RandomInput(rng, matchTick++, input);
+        clock.Tick(level, input);
+    }
+    result = clock.Finish();
+    return true;
+}
+
+struct Scenario {
+    const char* name;
+    bool (*run)(StressResult& result);
+};
+
+static const Scenario scenarios[] = {
+    {"huge_map", HugeMap},
+    {"bullet_storm", BulletStorm},
+    {"chain_destruction", ChainDestruction},
+    {"barrel_chain", BarrelChain},
+    {"long_session", LongSession},
+};
+
+// scenario,ticks_per_sec,p99_ms,peak_kb. A peak of 0 is not checked.
+static bool LoadBaselines(const std::string& path, std::map<std::string, StressResult>& baselines) {
+    std::ifstream input(path);
+    if (!input) return false;
+
+    std::string line;
+    std::getline(input, line);  // header
+    while (std::getline(input, line)) {
+        std::istringstream fields(line);
+        std::string name, tps, p99, peak;
+        if (!std::getline(fields, name, ',') || !std::getline(fields, tps, ',') || !std::getline(fields, p99, ',') ||
+            !std::getline(fields, peak, ',')) {
+            continue;
+        }
+        StressResult baseline = {0, 0, 0, 0, 0};
+        baseline.ticksPerSecond = std::atof(tps.c_str());
+        baseline.p99Ms = std::atof(p99.c_str());
+        baseline.peakKb = std::strtoull(peak.c_str(), nullptr, 10);
+        baselines[name] = baseline;
+    }
+    return true;
+}
+
+static bool SaveBaselines(const std::string& path, const std::map<std::string, StressResult>& baselines) {
+    std::ofstream output(path);
+    if (!output) return false;
+    output << "scenario,ticks_per_sec,p99_ms,peak_kb\n";
+    for (const auto& [name, baseline] : baselines) {
+        char line[160];
+        std::snprintf(line, sizeof(line), "%s,%.0f,%.4f,%llu\n", name.c_str(), baseline.ticksPerSecond,
+                      baseline.p99Ms, (unsigned long long)baseline.peakKb);
+        output << line;
+    }
+    return (bool)output;
+}
+
+const double P99_NOISE_MS = 0.005;
+
+// Prints what got worse, true when nothing went past the tolerance
+static bool CheckBaseline(const StressResult& result, const StressResult& baseline, double tolerance, bool checkPeak) {
+    bool passed = true;
+    char line[160];
+    if (result.ticksPerSecond < baseline.ticksPerSecond * (1.0 - tolerance)) {
+        std::snprintf(line, sizeof(line), "  ticks/s %.0f, baseline %.0f", result.ticksPerSecond,
+                      baseline.ticksPerSecond);
+        std::cout << line << std::endl;
+        passed = false;
+    }
+    // Below a few microseconds p99 is mostly timer and scheduler noise
+    if (result.p99Ms > baseline.p99Ms * (1.0 + tolerance) && result.p99Ms - baseline.p99Ms > P99_NOISE_MS) {
+        std::snprintf(line, sizeof(line), "  p99 %.4f ms, baseline %.4f ms", result.p99Ms, baseline.p99Ms);
+        std::cout << line << std::endl;
+        passed = false;
+    }
+    if (checkPeak && baseline.peakKb > 0 && result.peakKb > baseline.peakKb * (1.0 + tolerance)) {
+        std::snprintf(line, sizeof(line), "  peak %llu KB, baseline %llu KB", (unsigned long long)result.peakKb,
+                      (unsigned long long)baseline.peakKb);
+        std::cout << line << std::endl;
+        passed = false;
+    }
+    return passed;
+}
+
+int main(int argc, char** argv) {
+    std::string baselinePath;
+    std::string recordPath;
+    double tolerance = 0.25;
+    std::vector<const Scenario*> selected;
+
+    // --key=value, so CTest can pass or leave out each option as one argument
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.empty()) continue;
+        if (arg.compare(0, 11, "--baseline=") == 0) {
+            baselinePath = arg.substr(11);
+        } else if (arg.compare(0, 12, "--tolerance=") == 0) {
+            tolerance = std::atof(arg.c_str() + 12);
+        } else if (arg.compare(0, 9, "--record=") == 0) {
+            recordPath = arg.substr(9);
+        } else {
+            const Scenario* found = nullptr;
+            for (const Scenario& scenario : scenarios) {
+                if (arg == scenario.name) found = &scenario;
+            }
+            if (!found) {
+                std::cerr << "usage: bomber_stress [--baseline=<file>] [--tolerance=<fraction>] [--record=<file>] "
+                             "[huge_map|bullet_storm|chain_destruction|barrel_chain|long_session]..."
+                          << std::endl;
+                return 1;
+            }
+            selected.push_back(found);
+        }
+    }
+    if (selected.empty()) {
+        for (const Scenario& scenario : scenarios) {
+            selected.push_back(&scenario);
+        }
+    }
+    bool singleRun = selected.size() == 1;
+
+    std::map<std::string, StressResult> baselines;
+    if (!baselinePath.empty() && !LoadBaselines(baselinePath, baselines)) {
+        std::cerr << "cannot read " << baselinePath << std::endl;
+        return 1;
+    }
+
+    std::map<std::string, StressResult> recorded;
+    if (!recordPath.empty()) {
+        LoadBaselines(recordPath, recorded);
+    }
+
+    bool regressed = false;
+    for (const Scenario* scenario : selected) {
+        StressResult result;
+        if (!scenario->run(result)) return 1;
+
+        char line[200];
+        std::snprintf(line, sizeof(line), "%-18s %8lld ticks  %7.2f s  %9.0f ticks/s  p99 %.4f ms  peak %llu KB%s",
+                      scenario->name, result.ticks, result.seconds, result.ticksPerSecond, result.p99Ms,
+                      (unsigned long long)result.peakKb, singleRun ? "" : " (process)");
+        std::cout << line << std::endl;
+
+        auto baseline = baselines.find(scenario->name);
+        if (!baselinePath.empty()) {
+            if (baseline == baselines.end()) {
+                std::cout << "  no baseline for " << scenario->name << std::endl;
+            } else if (!CheckBaseline(result, baseline->second, tolerance, singleRun)) {
+                std::cout << "  regression in " << scenario->name << std::endl;
+                regressed = true;
+            }
+        }
+
+        if (!recordPath.empty()) {
+            StressResult& entry = recorded[scenario->name];
+            uint64_t previousPeak = entry.peakKb;
+            entry = result;
+            entry.peakKb = singleRun ? result.peakKb : previousPeak;
+        }
+    }
+
+    if (!recordPath.empty()) {
+        if (!SaveBaselines(recordPath, recorded)) {
+            std::cerr << "cannot write " << recordPath << std::endl;
+            return 1;
+        }
+        std::cout << "baselines written to " << recordPath << std::endl;
+    }
+    return regressed ? 2 : 0;
+}
@@ -0,0 +1,115 @@
+#include "BulletKernels.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BULLET_LANES 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BULLET_LANES 4
+#else
+#define BULLET_LANES 1
+#endif
+
+namespace {
+
+// Reference path, also handles the tail that doesn't fill a vector
+void IntegrateScalar(float* posX, float* posY, float* prevX, float* prevY,
+                     const float* velX, const float* velY, uint8_t* flags,
+                     size_t begin, size_t end, float dt, Rectangle bounds) {
+    float maxX = bounds.x + bounds.width;
+    float maxY = bounds.y + bounds.height;
+
+    for (size_t i = begin; i < end; i++) {
+        prevX[i] = posX[i];
+        prevY[i] = posY[i];
+        float stepX = velX[i] * dt;
+        float stepY = velY[i] * dt;
+        posX[i] = posX[i] + stepX;
+        posY[i] = posY[i] + stepY;
+
+        // Check if bullet is out of bounds
+        if (posX[i] < bounds.x || posX[i] > maxX || posY[i] < bounds.y || posY[i] > maxY) {
+            flags[i] |= BULLET_DEAD;
+        }
+    }
+}
+
+} // namespace
+
+void IntegrateBullets(float* posX, float* posY, float* prevX, float* prevY,
+                      const float* velX, const float* velY, uint8_t* flags,
+                      size_t count, float dt, Rectangle bounds) {
+    size_t i = 0;
+
+#if BULLET_LANES == 8
+    const __m256 step = _mm256_set1_ps(dt);
+    const __m256 minX = _mm256_set1_ps(bounds.x);
+    const __m256 minY = _mm256_set1_ps(bounds.y);
+    const __m256 maxX = _mm256_set1_ps(bounds.x + bounds.width);
+    const __m256 maxY = _mm256_set1_ps(bounds.y + bounds.height);
+
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_loadu_ps(posX + i);
+        __m256 y = _mm256_loadu_ps(posY + i);
+        _mm256_storeu_ps(prevX + i, x);
+        _mm256_storeu_ps(prevY + i, y);
+
+        x = _mm256_add_ps(x, _mm256_mul_ps(_mm256_loadu_ps(velX + i), step));
+        y = _mm256_add_ps(y, _mm256_mul_ps(_mm256_loadu_ps(velY + i), step));
+        _mm256_storeu_ps(posX + i, x);
+        _mm256_storeu_ps(posY + i, y);
+
+        __m256 out = _mm256_or_ps(
+            _mm256_or_ps(_mm256_cmp_ps(x, minX, _CMP_LT_OQ), _mm256_cmp_ps(x, maxX, _CMP_GT_OQ)),
+            _mm256_or_ps(_mm256_cmp_ps(y, minY, _CMP_LT_OQ), _mm256_cmp_ps(y, maxY, _CMP_GT_OQ)));
+
+        // Almost every lane stays in bounds, only touch flags for the few that don't
+        int mask = _mm256_movemask_ps(out);
+        for (int lane = 0; mask; lane++, mask >>= 1) {
+            if (mask & 1) {
+                flags[i + lane] |= BULLET_DEAD;
+            }
+        }
+    }
+#elif BULLET_LANES == 4
+    const __m128 step = _mm_set1_ps(dt);
+    const __m128 minX = _mm_set1_ps(bounds.x);
+    const __m128 minY = _mm_set1_ps(bounds.y);
+    const __m128 maxX = _mm_set1_ps(bounds.x + bounds.width);
+    const __m128 maxY = _mm_set1_ps(bounds.y + bounds.height);
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(posX + i);
+        __m128 y = _mm_loadu_ps(posY + i);
+        _mm_storeu_ps(prevX + i, x);
+        _mm_storeu_ps(prevY + i, y);
+
+        x = _mm_add_ps(x, _mm_mul_ps(_mm_loadu_ps(velX + i), step));
+        y = _mm_add_ps(y, _mm_mul_ps(_mm_loadu_ps(velY + i), step));
+        _mm_storeu_ps(posX + i, x);
+        _mm_storeu_ps(posY + i, y);
+
+        __m128 out = _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(x, minX), _mm_cmpgt_ps(x, maxX)),
+                               _mm_or_ps(_mm_cmplt_ps(y, minY), _mm_cmpgt_ps(y, maxY)));
+
+        int mask = _mm_movemask_ps(out);
+        for (int lane = 0; mask; lane++, mask >>= 1) {
+            if (mask & 1) {
+                flags[i + lane] |= BULLET_DEAD;
+            }
+        }
+    }
+#endif
+
+    IntegrateScalar(posX, posY, prevX, prevY, velX, velY, flags, i, count, dt, bounds);
+}
+
+const char* GetBulletKernelName() {
+#if BULLET_LANES == 8
+    return "avx2";
+#elif BULLET_LANES == 4
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,23 @@
+#ifndef BULLETKERNELS_H
+#define BULLETKERNELS_H
+
+#include "raylib.h"
+#include <cstddef>
+#include <cstdint>
+
+// BulletPool flag bits
+const uint8_t BULLET_POWER_UP = 1 << 0;
+const uint8_t BULLET_DEAD = 1 << 1;
+
+// Moves count bullets by their velocity over dt, remembers where they were
+// and flags every bullet that left bounds as BULLET_DEAD. Uses AVX2 (8 lanes)
+// or SSE2 (4 lanes) when the build enables them, plain C++ otherwise; all
+// paths do the same float ops in the same order, so results match exactly.
+void IntegrateBullets(float* posX, float* posY, float* prevX, float* prevY,
+                      const float* velX, const float* velY, uint8_t* flags,
+                      size_t count, float dt, Rectangle bounds);
+
+// Name of the path IntegrateBullets was compiled with, for benchmark output
+const char* GetBulletKernelName();
+
+#endif
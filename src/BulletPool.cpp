@@ -0,0 +1,244 @@
+#include "BulletPool.h"
+#include <cstring>
+
+BulletPool::BulletPool(size_t capacity)
+    : count(0), capacity(capacity) {
+    posX.assign(capacity, 0.0f);
+    posY.assign(capacity, 0.0f);
+    prevX.assign(capacity, 0.0f);
+    prevY.assign(capacity, 0.0f);
+    velX.assign(capacity, 0.0f);
+    velY.assign(capacity, 0.0f);
+    flags.assign(capacity, 0);
+    owners.assign(capacity, INVALID_ENTITY);
+    teams.assign(capacity, TEAM_PLAYER);
+    denseToSlot.assign(capacity, 0);
+    slotToDense.assign(capacity, UINT32_MAX);
+    generations.assign(capacity, 0);
+    freeSlots.reserve(capacity);
+    Clear();
+}
+
+BulletHandle BulletPool::Spawn(Vector2 position, Vector2 direction, bool powerUp, Entity owner, uint8_t team) {
+    if (freeSlots.empty()) {
+        return INVALID_BULLET;
+    }
+
+    uint32_t slot = freeSlots.back();
+    freeSlots.pop_back();
+
+    size_t i = count++;
+    posX[i] = prevX[i] = position.x;
+    posY[i] = prevY[i] = position.y;
+    velX[i] = direction.x * BULLET_SPEED;
+    velY[i] = direction.y * BULLET_SPEED;
+    flags[i] = powerUp ? BULLET_POWER_UP : 0;
+    owners[i] = owner;
+    teams[i] = team;
+
+    denseToSlot[i] = slot;
+    slotToDense[slot] = (uint32_t)i;
+    return {slot, generations[slot]};
+}
+
+size_t BulletPool::IndexOf(BulletHandle handle) const {
+    if (handle.slot >= capacity || generations[handle.slot] != handle.generation ||
+        slotToDense[handle.slot] == UINT32_MAX) {
+        return SIZE_MAX;
+    }
+    return slotToDense[handle.slot];
+}
+
+void BulletPool::Update(float dt, Rectangle bounds) {
+    IntegrateBullets(posX.data(), posY.data(), prevX.data(), prevY.data(),
+                     velX.data(), velY.data(), flags.data(), count, dt, bounds);
+
+    for (size_t i = 0; i < count;) {
+        if (flags[i] & BULLET_DEAD) {
+            // Swaps the last bullet in, so look at index i again
+            RemoveAt(i);
+        } else {
+            i++;
+        }
+    }
+}
+
+void BulletPool::RemoveAt(size_t index) {
+    uint32_t slot = denseToSlot[index];
+    size_t last = --count;
+
+    // Move the last bullet into the hole and fix up its slot
+    if (index != last) {
+        posX[index] = posX[last];
+        posY[index] = posY[last];
+        prevX[index] = prevX[last];
+        prevY[index] = prevY[last];
+        velX[index] = velX[last];
+        velY[index] = velY[last];
+        flags[index] = flags[last];
+        owners[index] = owners[last];
+        teams[index] = teams[last];
+        denseToSlot[index] = denseToSlot[last];
+        slotToDense[denseToSlot[index]] = (uint32_t)index;
+    }
+
+    slotToDense[slot] = UINT32_MAX;
+    generations[slot]++;
+    freeSlots.push_back(slot);
+}
+
+void BulletPool::Clear() {
+    for (size_t i = 0; i < count; i++) {
+        slotToDense[denseToSlot[i]] = UINT32_MAX;
+        generations[denseToSlot[i]]++;
+    }
+    count = 0;
+
+    // Hand out low slots first
+    freeSlots.clear();
+    for (size_t i = capacity; i > 0; i--) {
+        freeSlots.push_back((uint32_t)(i - 1));
+    }
+}
+
+void BulletPool::SaveState(Snapshot& snapshot) const {
+    snapshot.WriteValue(capacity);
+    snapshot.WriteValue(count);
+    snapshot.Write(posX.data(), count * sizeof(float));
+    snapshot.Write(posY.data(), count * sizeof(float));
+    snapshot.Write(prevX.data(), count * sizeof(float));
+    snapshot.Write(prevY.data(), count * sizeof(float));
+    snapshot.Write(velX.data(), count * sizeof(float));
+    snapshot.Write(velY.data(), count * sizeof(float));
+    snapshot.Write(flags.data(), count * sizeof(uint8_t));
+    snapshot.Write(owners.data(), count * sizeof(Entity));
+    snapshot.Write(teams.data(), count * sizeof(uint8_t));
+    snapshot.Write(denseToSlot.data(), count * sizeof(uint32_t));
+    snapshot.Write(slotToDense.data(), capacity * sizeof(uint32_t));
+    snapshot.Write(generations.data(), capacity * sizeof(uint32_t));
+    // One free slot per dead bullet, so the count is implied
+    snapshot.Write(freeSlots.data(), freeSlots.size() * sizeof(uint32_t));
+}
+
+bool BulletPool::RestoreState(const Snapshot& snapshot, size_t& offset) {
+    size_t savedCapacity = 0;
+    size_t savedCount = 0;
+    if (!snapshot.ReadValue(offset, savedCapacity) || savedCapacity != capacity ||
+        !snapshot.ReadValue(offset, savedCount) || savedCount > capacity) {
+        return false;
+    }
+
+    count = savedCount;
+    freeSlots.resize(capacity - count);
+    return snapshot.Read(offset, posX.data(), count * sizeof(float)) &&
+           snapshot.Read(offset, posY.data(), count * sizeof(float)) &&
+           snapshot.Read(offset, prevX.data(), count * sizeof(float)) &&
+           snapshot.Read(offset, prevY.data(), count * sizeof(float)) &&
+           snapshot.Read(offset, velX.data(), count * sizeof(float)) &&
+           snapshot.Read(offset, velY.data(), count * sizeof(float)) &&
+           snapshot.Read(offset, flags.data(), count * sizeof(uint8_t)) &&
+           snapshot.Read(offset, owners.data(), count * sizeof(Entity)) &&
+           snapshot.Read(offset, teams.data(), count * sizeof(uint8_t)) &&
+           snapshot.Read(offset, denseToSlot.data(), count * sizeof(uint32_t)) &&
+           snapshot.Read(offset, slotToDense.data(), capacity * sizeof(uint32_t)) &&
+           snapshot.Read(offset, generations.data(), capacity * sizeof(uint32_t)) &&
+           snapshot.Read(offset, freeSlots.data(), freeSlots.size() * sizeof(uint32_t));
+}
+
+bool BulletPool::SkipState(const Snapshot& snapshot, size_t& offset) const {
+    size_t savedCapacity = 0;
+    size_t savedCount = 0;
+    if (!snapshot.ReadValue(offset, savedCapacity) || savedCapacity != capacity ||
+        !snapshot.ReadValue(offset, savedCount) || savedCount > capacity) {
+        return false;
+    }
+    size_t denseAt = offset + savedCount * (6 * sizeof(float) + 2 * sizeof(uint8_t) + sizeof(Entity));
+    size_t slotsAt = denseAt + savedCount * sizeof(uint32_t);
+    size_t freeAt = slotsAt + capacity * 2 * sizeof(uint32_t);
+    if (!snapshot.Skip(offset, slotsAt - offset) || !snapshot.Skip(offset, capacity * 2 * sizeof(uint32_t)) ||
+        !snapshot.Skip(offset, (capacity - savedCount) * sizeof(uint32_t))) {
+        return false;
+    }
+
+    // Slots and dense indices have to point at each other one to one, and
+    // free slots be real ones, Spawn and RemoveAt index by them
+    const unsigned char* data = snapshot.Data();
+    size_t mapped = 0;
+    for (size_t slot = 0; slot < capacity; slot++) {
+        uint32_t dense = 0;
+        uint32_t back = 0;
+        std::memcpy(&dense, data + slotsAt + slot * sizeof(uint32_t), sizeof(dense));
+        if (dense == UINT32_MAX) continue;
+        if (dense >= savedCount) return false;
+        std::memcpy(&back, data + denseAt + dense * sizeof(uint32_t), sizeof(back));
+        if (back != slot) return false;
+        mapped++;
+    }
+    for (size_t i = 0; i < capacity - savedCount; i++) {
+        uint32_t slot = 0;
+        std::memcpy(&slot, data + freeAt + i * sizeof(uint32_t), sizeof(slot));
+        if (slot >= capacity) return false;
+    }
+    return mapped == savedCount;
+}
+
+size_t BulletPool::Size() const {
+    return count;
+}
+
+size_t BulletPool::Capacity() const {
+    return capacity;
+}
+
+bool BulletPool::IsFull() const {
+    return count >= capacity;
+}
+
+BulletHandle BulletPool::GetHandle(size_t index) const {
+    uint32_t slot = denseToSlot[index];
+    return {slot, generations[slot]};
+}
+
+Vector2 BulletPool::GetPosition(size_t index) const {
+    return {posX[index], posY[index]};
+}
+
+Vector2 BulletPool::GetPreviousPosition(size_t index) const {
+    return {prevX[index], prevY[index]};
+}
+
+Vector2 BulletPool::GetVelocity(size_t index) const {
+    return {velX[index], velY[index]};
+}
+
+Rectangle BulletPool::GetHitbox(size_t index) const {
+    // Bullet hitbox: 8x8 centered on position
+    return {posX[index] - 4, posY[index] - 4, 8, 8};
+}
+
+bool BulletPool::HasPowerUp(size_t index) const {
+    return flags[index] & BULLET_POWER_UP;
+}
+
+Entity BulletPool::GetOwner(size_t index) const {
+    return owners[index];
+}
+
+uint8_t BulletPool::GetTeam(size_t index) const {
+    return teams[index];
+}
+
+bool BulletPool::ShouldDestroy(size_t index) const {
+    return flags[index] & BULLET_DEAD;
+}
+
+void BulletPool::MarkForDestruction(size_t index) {
+    flags[index] |= BULLET_DEAD;
+}
+
+void BulletPool::SetPositions(size_t index, Vector2 previous, Vector2 position) {
+    prevX[index] = previous.x;
+    prevY[index] = previous.y;
+    posX[index] = position.x;
+    posY[index] = position.y;
+}
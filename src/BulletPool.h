@@ -0,0 +1,87 @@
+#ifndef BULLETPOOL_H
+#define BULLETPOOL_H
+
+#include "raylib.h"
+#include "BulletKernels.h"
+#include "EntityStore.h"
+#include "Snapshot.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+const float BULLET_SPEED = 300.0f; // pixels per second
+
+// Stable reference to a pooled bullet. The slot survives swap-removal of
+// other bullets, the generation catches handles to bullets that are gone.
+struct BulletHandle {
+    uint32_t slot;
+    uint32_t generation;
+};
+
+const BulletHandle INVALID_BULLET = {UINT32_MAX, 0};
+
+// Fixed-capacity bullet storage, one array per field so the update kernel
+// streams through plain floats. Live bullets are packed at the front,
+// removal swaps the last bullet into the hole, and nothing is allocated
+// after construction.
+class BulletPool {
+private:
+    std::vector<float> posX;
+    std::vector<float> posY;
+    std::vector<float> prevX;
+    std::vector<float> prevY;
+    std::vector<float> velX;
+    std::vector<float> velY;
+    std::vector<uint8_t> flags;
+    std::vector<Entity> owners;   // tank that fired, gets the power-ups it hits
+    std::vector<uint8_t> teams;   // never hurts colliders of this team
+    std::vector<uint32_t> denseToSlot;
+    std::vector<uint32_t> slotToDense;
+    std::vector<uint32_t> generations;    // per slot, bumped on removal
+    std::vector<uint32_t> freeSlots;
+    size_t count;
+    size_t capacity;
+
+public:
+    explicit BulletPool(size_t capacity = 32);
+
+    // Returns INVALID_BULLET when the pool is full
+    BulletHandle Spawn(Vector2 position, Vector2 direction, bool powerUp,
+                       Entity owner = INVALID_ENTITY, uint8_t team = TEAM_PLAYER);
+    // Dense index of the bullet, or SIZE_MAX once it has been removed
+    size_t IndexOf(BulletHandle handle) const;
+    // Moves every bullet and removes the ones that left bounds or were
+    // marked for destruction
+    void Update(float dt, Rectangle bounds);
+    void RemoveAt(size_t index);
+    void Clear();
+    // In LevelDraw.cpp, with the other draw code
+    void Draw(bool debugMode, float alpha = 1.0f) const;
+    // Live bullets plus the slot bookkeeping, so handles stay valid across
+    // a restore. Restore fails if the capacity differs.
+    void SaveState(Snapshot& snapshot) const;
+    bool RestoreState(const Snapshot& snapshot, size_t& offset);
+    // What RestoreState would read, checked without changing anything
+    bool SkipState(const Snapshot& snapshot, size_t& offset) const;
+
+    size_t Size() const;
+    size_t Capacity() const;
+    bool IsFull() const;
+
+    // Handle of the bullet at a dense index
+    BulletHandle GetHandle(size_t index) const;
+    Vector2 GetPosition(size_t index) const;
+    Vector2 GetPreviousPosition(size_t index) const;
+    Vector2 GetVelocity(size_t index) const;
+    Rectangle GetHitbox(size_t index) const;
+    bool HasPowerUp(size_t index) const;
+    Entity GetOwner(size_t index) const;
+    uint8_t GetTeam(size_t index) const;
+    bool ShouldDestroy(size_t index) const;
+    void MarkForDestruction(size_t index);
+    // Places a bullet without moving it, for showing positions that were
+    // simulated elsewhere
+    void SetPositions(size_t index, Vector2 previous, Vector2 position);
+};
+
+#endif
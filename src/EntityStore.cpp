@@ -0,0 +1,110 @@
+#include "EntityStore.h"
+
+Entity EntityStore::Create() {
+    uint32_t index;
+    if (!freeIndices.empty()) {
+        index = freeIndices.back();
+        freeIndices.pop_back();
+    } else {
+        index = (uint32_t)generations.size();
+        generations.push_back(0);
+        alive.push_back(0);
+    }
+    alive[index] = 1;
+    return {index, generations[index]};
+}
+
+void EntityStore::Destroy(Entity entity) {
+    if (!IsAlive(entity)) return;
+
+    transforms.Remove(entity.index);
+    velocities.Remove(entity.index);
+    colliders.Remove(entity.index);
+    weapons.Remove(entity.index);
+    healths.Remove(entity.index);
+    appearances.Remove(entity.index);
+    pathFollowers.Remove(entity.index);
+
+    alive[entity.index] = 0;
+    generations[entity.index]++;
+    freeIndices.push_back(entity.index);
+}
+
+bool EntityStore::IsAlive(Entity entity) const {
+    return entity.index < generations.size() && alive[entity.index] &&
+           generations[entity.index] == entity.generation;
+}
+
+Entity EntityStore::GetEntity(uint32_t index) const {
+    if (index >= generations.size() || !alive[index]) return INVALID_ENTITY;
+    return {index, generations[index]};
+}
+
+size_t EntityStore::Count() const {
+    return generations.size() - freeIndices.size();
+}
+
+void EntityStore::Clear() {
+    // Old handles stay invalid, and low indices are handed out first again
+    freeIndices.clear();
+    for (size_t i = generations.size(); i > 0; i--) {
+        if (alive[i - 1]) {
+            generations[i - 1]++;
+            alive[i - 1] = 0;
+        }
+        freeIndices.push_back((uint32_t)(i - 1));
+    }
+
+    transforms.Clear();
+    velocities.Clear();
+    colliders.Clear();
+    weapons.Clear();
+    healths.Clear();
+    appearances.Clear();
+    pathFollowers.Clear();
+}
+
+void EntityStore::SaveState(Snapshot& snapshot) const {
+    snapshot.WriteValue(generations.size());
+    snapshot.WriteValue(freeIndices.size());
+    snapshot.Write(generations.data(), generations.size() * sizeof(uint32_t));
+    snapshot.Write(alive.data(), alive.size() * sizeof(uint8_t));
+    snapshot.Write(freeIndices.data(), freeIndices.size() * sizeof(uint32_t));
+
+    transforms.SaveState(snapshot);
+    velocities.SaveState(snapshot);
+    colliders.SaveState(snapshot);
+    weapons.SaveState(snapshot);
+    healths.SaveState(snapshot);
+    appearances.SaveState(snapshot);
+    pathFollowers.SaveState(snapshot);
+}
+
+bool EntityStore::RestoreState(const Snapshot& snapshot, size_t& offset) {
+    size_t count = 0;
+    size_t freeCount = 0;
+    if (!snapshot.ReadValue(offset, count) || !snapshot.ReadValue(offset, freeCount) ||
+        freeCount > count || count > snapshot.Size()) {
+        return false;
+    }
+
+    generations.resize(count);
+    alive.resize(count);
+    freeIndices.resize(freeCount);
+    if (!snapshot.Read(offset, generations.data(), count * sizeof(uint32_t)) ||
+        !snapshot.Read(offset, alive.data(), count * sizeof(uint8_t)) ||
+        !snapshot.Read(offset, freeIndices.data(), freeCount * sizeof(uint32_t))) {
+        return false;
+    }
+    // Create hands the free indices out again
+    for (uint32_t index : freeIndices) {
+        if (index >= count || alive[index]) return false;
+    }
+    return transforms.RestoreState(snapshot, offset) &&
+           velocities.RestoreState(snapshot, offset) &&
+           colliders.RestoreState(snapshot, offset) &&
+           weapons.RestoreState(snapshot, offset) &&
+           healths.RestoreState(snapshot, offset) &&
+           appearances.RestoreState(snapshot, offset) &&
+           pathFollowers.RestoreState(snapshot, offset);
+}
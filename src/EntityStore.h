@@ -0,0 +1,229 @@
+#ifndef ENTITYSTORE_H
+#define ENTITYSTORE_H
+
+#include "raylib.h"
+#include "Snapshot.h"
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+// Stable reference to an entity. The generation catches handles to
+// entities that were destroyed and whose index got reused.
+struct Entity {
+    uint32_t index;
+    uint32_t generation;
+};
+
+const Entity INVALID_ENTITY = {UINT32_MAX, 0};
+
+// Bullets only hurt colliders of another team
+const uint8_t TEAM_PLAYER = 0;
+const uint8_t TEAM_ENEMY = 1;
+const uint8_t TEAM_NEUTRAL = 2;
+const int TEAM_COUNT = 3;
+
+struct Transform {
+    Vector2 position;
+    Vector2 previousPosition;  // at the start of the tick, for drawing
+    Vector2 direction;         // facing, also the firing direction
+};
+
+struct Velocity {
+    Vector2 move;  // requested direction this tick, {0, 0} to stand still
+    float speed;   // pixels per second
+};
+
+struct Collider {
+    Vector2 size;  // centred on the position
+    uint8_t team;
+};
+
+struct Weapon {
+    float cooldown;
+    float timer;   // fires once it is down to 0
+    bool trigger;  // fire this tick if the timer allows, cleared after
+    bool powerUp;
+};
+
+struct Health {
+    int hitPoints;
+};
+
+// What an entity is drawn as, the draw code picks the atlas sprite
+enum class EntitySprite : uint8_t {
+    TANK
+};
+const int ENTITY_SPRITE_COUNT = 1;
+
+struct Appearance {
+    EntitySprite sprite;
+    Color tint;
+};
+
+// Drives the tank along the level's flow field toward the player
+struct PathFollower {
+    Vector2 waypoint;  // centre of the cell it is heading for
+    bool hasWaypoint;
+};
+
+// Packed storage for one component type. Components are contiguous in no
+// particular order, so systems walk them with a plain index loop and ask
+// Owner(i) which entity one belongs to. Removal swaps the last component
+// into the hole, lookup maps an entity index back to its component.
+template <typename T>
+class ComponentArray {
+private:
+    std::vector<T> components;
+    std::vector<uint32_t> owners;  // entity index of each component
+    std::vector<uint32_t> lookup;  // entity index -> component, UINT32_MAX if none
+
+public:
+    T& Add(uint32_t entity, const T& component) {
+        if (entity >= lookup.size()) {
+            lookup.resize(entity + 1, UINT32_MAX);
+        }
+        if (lookup[entity] != UINT32_MAX) {
+            return components[lookup[entity]] = component;
+        }
+        lookup[entity] = (uint32_t)components.size();
+        components.push_back(component);
+        owners.push_back(entity);
+        return components.back();
+    }
+
+    void Remove(uint32_t entity) {
+        if (entity >= lookup.size() || lookup[entity] == UINT32_MAX) return;
+
+        uint32_t index = lookup[entity];
+        uint32_t last = (uint32_t)components.size() - 1;
+        if (index != last) {
+            components[index] = components[last];
+            owners[index] = owners[last];
+            lookup[owners[index]] = index;
+        }
+        components.pop_back();
+        owners.pop_back();
+        lookup[entity] = UINT32_MAX;
+    }
+
+    T* Find(uint32_t entity) {
+        if (entity >= lookup.size() || lookup[entity] == UINT32_MAX) return nullptr;
+        return &components[lookup[entity]];
+    }
+
+    const T* Find(uint32_t entity) const {
+        return const_cast<ComponentArray*>(this)->Find(entity);
+    }
+
+    size_t Size() const {
+        return components.size();
+    }
+
+    T& operator[](size_t index) {
+        return components[index];
+    }
+
+    const T& operator[](size_t index) const {
+        return components[index];
+    }
+
+    uint32_t Owner(size_t index) const {
+        return owners[index];
+    }
+
+    void Clear() {
+        components.clear();
+        owners.clear();
+        lookup.assign(lookup.size(), UINT32_MAX);
+    }
+
+    void SaveState(Snapshot& snapshot) const {
+        static_assert(std::is_trivially_copyable<T>::value, "components must be plain values");
+        snapshot.WriteValue(components.size());
+        snapshot.WriteValue(lookup.size());
+        snapshot.Write(components.data(), components.size() * sizeof(T));
+        snapshot.Write(owners.data(), owners.size() * sizeof(uint32_t));
+        snapshot.Write(lookup.data(), lookup.size() * sizeof(uint32_t));
+    }
+
+    bool RestoreState(const Snapshot& snapshot, size_t& offset) {
+        size_t count = 0;
+        size_t lookupSize = 0;
+        if (!snapshot.ReadValue(offset, count) || !snapshot.ReadValue(offset, lookupSize) ||
+            count > lookupSize || lookupSize > snapshot.Size()) {
+            return false;
+        }
+        components.resize(count);
+        owners.resize(count);
+        lookup.resize(lookupSize);
+        if (!snapshot.Read(offset, components.data(), count * sizeof(T)) ||
+            !snapshot.Read(offset, owners.data(), count * sizeof(uint32_t)) ||
+            !snapshot.Read(offset, lookup.data(), lookupSize * sizeof(uint32_t))) {
+            return false;
+        }
+
+        // Owners and lookup have to point at each other one to one, Remove
+        // and Find index by them
+        size_t mapped = 0;
+        for (uint32_t index : lookup) {
+            if (index == UINT32_MAX) continue;
+            if (index >= count) return false;
+            mapped++;
+        }
+        for (size_t i = 0; i < count; i++) {
+            if (owners[i] >= lookupSize || lookup[owners[i]] != i) return false;
+        }
+        return mapped == count;
+    }
+};
+
+// Every tank and other object that isn't a tile or a bullet. An entity is
+// just an index; what it is comes from the components it has. A tank has
+// all six, enemy tanks also a path follower, a neutral object might only
+// have a transform, collider, health and appearance. Systems in
+// LevelManager run over the packed arrays.
+class EntityStore {
+private:
+    std::vector<uint32_t> generations;  // per index, bumped on destroy
+    std::vector<uint8_t> alive;
+    std::vector<uint32_t> freeIndices;
+    ComponentArray<Transform> transforms;
+    ComponentArray<Velocity> velocities;
+    ComponentArray<Collider> colliders;
+    ComponentArray<Weapon> weapons;
+    ComponentArray<Health> healths;
+    ComponentArray<Appearance> appearances;
+    ComponentArray<PathFollower> pathFollowers;
+
+public:
+    Entity Create();
+    // Removes the entity and all its components, stale handles are ignored
+    void Destroy(Entity entity);
+    bool IsAlive(Entity entity) const;
+    // Handle of a live entity by index, INVALID_ENTITY if there is none
+    Entity GetEntity(uint32_t index) const;
+    size_t Count() const;
+    void Clear();
+    void SaveState(Snapshot& snapshot) const;
+    // False if the snapshot is cut short or its bookkeeping doesn't add
+    // up, the store is then left half restored
+    bool RestoreState(const Snapshot& snapshot, size_t& offset);
+
+    ComponentArray<Transform>& Transforms() { return transforms; }
+    ComponentArray<Velocity>& Velocities() { return velocities; }
+    ComponentArray<Collider>& Colliders() { return colliders; }
+    ComponentArray<Weapon>& Weapons() { return weapons; }
+    ComponentArray<Health>& Healths() { return healths; }
+    ComponentArray<Appearance>& Appearances() { return appearances; }
+    ComponentArray<PathFollower>& PathFollowers() { return pathFollowers; }
+    const ComponentArray<Transform>& Transforms() const { return transforms; }
+    const ComponentArray<Velocity>& Velocities() const { return velocities; }
+    const ComponentArray<Collider>& Colliders() const { return colliders; }
+    const ComponentArray<Weapon>& Weapons() const { return weapons; }
+    const ComponentArray<Health>& Healths() const { return healths; }
+    const ComponentArray<Appearance>& Appearances() const { return appearances; }
+    const ComponentArray<PathFollower>& PathFollowers() const { return pathFollowers; }
+};
+
+#endif
@@ -0,0 +1,199 @@
+#include "FlowField.h"
+#include <algorithm>
+
+FlowField::FlowField() : originX(0), originY(0), width(0), height(0), stride(2), target(-1), built(false),
+                         targetMoved(false), lastRepairCount(0) {}
+
+void FlowField::Reset(int newOriginX, int newOriginY, int newWidth, int newHeight) {
+    originX = newOriginX;
+    originY = newOriginY;
+    width = newWidth;
+    height = newHeight;
+    stride = width + 2;
+    target = -1;
+    built = false;
+    targetMoved = false;
+
+    size_t cells = (size_t)stride * (height + 2);
+    passable.assign(cells, 0);
+    distance.assign(cells, FLOW_UNREACHABLE);
+    lookahead.assign(cells, FLOW_UNREACHABLE);
+    flow.assign(cells, FlowDirection::NONE);
+    changedMark.assign(cells, 0);
+    changed.clear();
+    repairQueue = {};
+    lastRepairCount = 0;
+}
+
+int FlowField::CellIndex(int x, int y) const {
+    return (y - originY + 1) * stride + (x - originX + 1);
+}
+
+bool FlowField::Contains(int x, int y) const {
+    return x >= originX && y >= originY && x < originX + width && y < originY + height;
+}
+
+uint16_t FlowField::ComputeLookahead(int cell) const {
+    if (!passable[cell]) return FLOW_UNREACHABLE;
+    if (cell == target) return 0;
+
+    uint16_t best = std::min(std::min(distance[cell - 1], distance[cell + 1]),
+                             std::min(distance[cell - stride], distance[cell + stride]));
+    return best == FLOW_UNREACHABLE ? FLOW_UNREACHABLE : (uint16_t)(best + 1);
+}
+
+void FlowField::UpdateCell(int cell) {
+    lookahead[cell] = ComputeLookahead(cell);
+    if (distance[cell] != lookahead[cell]) {
+        uint64_t key = std::min(distance[cell], lookahead[cell]);
+        repairQueue.push(key << 32 | (uint32_t)cell);
+    }
+}
+
+void FlowField::SetDistance(int cell, uint16_t value) {
+    distance[cell] = value;
+    if (!changedMark[cell]) {
+        changedMark[cell] = 1;
+        changed.push_back(cell);
+    }
+}
+
+void FlowField::RefreshFlow(int cell) {
+    flow[cell] = FlowDirection::NONE;
+    if (cell == target || distance[cell] == FLOW_UNREACHABLE) return;
+
+    // The first neighbour that is closest wins ties, in this order
+    const int offsets[4] = {-1, 1, -stride, stride};
+    const FlowDirection directions[4] = {FlowDirection::LEFT, FlowDirection::RIGHT,
+                                         FlowDirection::UP, FlowDirection::DOWN};
+    uint16_t best = distance[cell];
+    for (int i = 0; i < 4; i++) {
+        if (distance[cell + offsets[i]] < best) {
+            best = distance[cell + offsets[i]];
+            flow[cell] = directions[i];
+        }
+    }
+}
+
+void FlowField::SetPassable(int x, int y, bool open) {
+    if (!Contains(x, y)) return;
+    int cell = CellIndex(x, y);
+    if ((passable[cell] != 0) == open) return;
+    passable[cell] = open ? 1 : 0;
+    if (!built) return;
+
+    // The cell itself and every neighbour that might step through it
+    UpdateCell(cell);
+    UpdateCell(cell - 1);
+    UpdateCell(cell + 1);
+    UpdateCell(cell - stride);
+    UpdateCell(cell + stride);
+}
+
+void FlowField::SetTarget(int x, int y) {
+    if (!Contains(x, y)) return;
+    int cell = CellIndex(x, y);
+    if (cell == target) return;
+
+    target = cell;
+    targetMoved = built;
+}
+
+void FlowField::Rebuild() {
+    std::fill(distance.begin(), distance.end(), FLOW_UNREACHABLE);
+    std::fill(flow.begin(), flow.end(), FlowDirection::NONE);
+    repairQueue = {};
+    built = true;
+    targetMoved = false;
+
+    bfsQueue.clear();
+    if (target >= 0 && passable[target]) {
+        distance[target] = 0;
+        bfsQueue.push_back(target);
+    }
+    const int offsets[4] = {-1, 1, -stride, stride};
+    for (size_t head = 0; head < bfsQueue.size(); head++) {
+        int cell = bfsQueue[head];
+        uint16_t next = distance[cell] + 1;
+        for (int offset : offsets) {
+            int neighbour = cell + offset;
+            if (passable[neighbour] && distance[neighbour] == FLOW_UNREACHABLE) {
+                distance[neighbour] = next;
+                bfsQueue.push_back(neighbour);
+            }
+        }
+    }
+
+    // Only reached cells have somewhere to go
+    lookahead = distance;
+    for (int cell : bfsQueue) {
+        RefreshFlow(cell);
+    }
+    lastRepairCount = bfsQueue.size();
+}
+
+void FlowField::Update() {
+    lastRepairCount = 0;
+    if (!built) return;
+    if (targetMoved) {
+        Rebuild();
+        return;
+    }
+    if (repairQueue.empty()) return;
+
+    while (!repairQueue.empty()) {
+        uint64_t entry = repairQueue.top();
+        repairQueue.pop();
+        int cell = (int)(entry & 0xffffffffu);
+        uint16_t key = (uint16_t)(entry >> 32);
+        uint16_t current = distance[cell];
+        uint16_t wanted = lookahead[cell];
+        if (current == wanted || key != std::min(current, wanted)) continue;
+
+        if (current > wanted) {
+            // Got closer: settle it, its neighbours may get closer too
+            SetDistance(cell, wanted);
+        } else {
+            // Got further: forget the old distance and work it out again
+            // once the cells it depended on have been settled
+            SetDistance(cell, FLOW_UNREACHABLE);
+            UpdateCell(cell);
+        }
+        UpdateCell(cell - 1);
+        UpdateCell(cell + 1);
+        UpdateCell(cell - stride);
+        UpdateCell(cell + stride);
+    }
+
+    // A step can only change next to a cell whose distance changed
+    for (int cell : changed) {
+        RefreshFlow(cell);
+        RefreshFlow(cell - 1);
+        RefreshFlow(cell + 1);
+        RefreshFlow(cell - stride);
+        RefreshFlow(cell + stride);
+    }
+    for (int cell : changed) {
+        changedMark[cell] = 0;
+    }
+    lastRepairCount = changed.size();
+    changed.clear();
+}
+
+bool FlowField::IsBuilt() const {
+    return built;
+}
+
+FlowDirection FlowField::GetFlow(int x, int y) const {
+    if (!Contains(x, y)) return FlowDirection::NONE;
+    return flow[CellIndex(x, y)];
+}
+
+uint16_t FlowField::GetDistance(int x, int y) const {
+    if (!Contains(x, y)) return FLOW_UNREACHABLE;
+    return distance[CellIndex(x, y)];
+}
+
+size_t FlowField::GetLastRepairCount() const {
+    return lastRepairCount;
+}
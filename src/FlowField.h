@@ -0,0 +1,89 @@
+#ifndef FLOWFIELD_H
+#define FLOWFIELD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <vector>
+
+// Step to take from a cell to get one cell closer to the target
+enum class FlowDirection : uint8_t {
+    NONE,  // the target itself, blocked, or no way there
+    LEFT,
+    RIGHT,
+    UP,
+    DOWN
+};
+
+const uint16_t FLOW_UNREACHABLE = UINT16_MAX;
+
+// Shortest walking distance from every cell of a rectangular window of the
+// grid to one target cell, and the direction to step from each cell. Any
+// number of tanks can follow it for one lookup each.
+//
+// Built with a BFS. When cells open up or close, only the cells whose
+// distance changes are repaired (Lifelong Planning A* without a goal): they
+// are put on a queue ordered by distance and settled from there outwards,
+// the rest of the field is never looked at. Moving the target by even one
+// cell changes nearly every distance, so that runs the BFS again, which is
+// much cheaper than repairing the whole field through the queue.
+class FlowField {
+private:
+    int originX;
+    int originY;
+    int width;
+    int height;
+    // The grids have a blocked border one cell wide, so neighbours are
+    // always at +-1 and +-stride without bounds checks
+    int stride;
+    int target;  // cell index, -1 before SetTarget
+    bool built;
+    bool targetMoved;  // since the last Rebuild
+    std::vector<uint8_t> passable;
+    std::vector<uint16_t> distance;
+    // 1 + the smallest neighbour distance (0 at the target). Differs from
+    // distance exactly for the cells that still need repairing.
+    std::vector<uint16_t> lookahead;
+    std::vector<FlowDirection> flow;
+    // Cells to repair, lowest min(distance, lookahead) first. Entries
+    // whose key went out of date are skipped when popped.
+    std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<uint64_t>> repairQueue;
+    std::vector<int> changed;         // cells whose distance changed this repair
+    std::vector<uint8_t> changedMark;
+    std::vector<int> bfsQueue;
+    size_t lastRepairCount;
+
+    int CellIndex(int x, int y) const;
+    uint16_t ComputeLookahead(int cell) const;
+    void UpdateCell(int cell);
+    void SetDistance(int cell, uint16_t value);
+    void RefreshFlow(int cell);
+
+public:
+    FlowField();
+    // Covers the cells [originX, originX + width) x [originY, originY + height),
+    // all blocked and without a target until filled in and rebuilt
+    void Reset(int originX, int originY, int width, int height);
+    // Cells outside the window are ignored. Once built, the change is
+    // repaired on the next Update.
+    void SetPassable(int x, int y, bool open);
+    // Ignored outside the window. Once built, the next Update rebuilds.
+    void SetTarget(int x, int y);
+    // Full BFS from the target
+    void Rebuild();
+    // Brings the field up to date with the changes since the last Update
+    // or Rebuild
+    void Update();
+
+    bool IsBuilt() const;
+    bool Contains(int x, int y) const;
+    // NONE outside the window
+    FlowDirection GetFlow(int x, int y) const;
+    // FLOW_UNREACHABLE outside the window
+    uint16_t GetDistance(int x, int y) const;
+    // Cells whose distance the last Update changed, or that the BFS reached
+    size_t GetLastRepairCount() const;
+};
+
+#endif
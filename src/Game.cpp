@@ -1,11 +1,14 @@
 #include "Game.h"
 #include "raylib.h"
+#include <algorithm>
+#include <iostream>
 
-Game::Game() : currentState(GameState::MENU), currentLevel(1), 
-               gameTime(0), levelTimeLimit(120.0f), levelCompleted(false), debugMode(false),
-               player(nullptr) {
+Game::Game() : currentState(GameState::MENU), currentLevel(0),
+               debugMode(false), showProfiler(false), accumulator(0), queuedShot(false), replaying(false),
+               remote(false) {
+    // Render rate is not tied to the simulation anymore, just follow the display
+    SetConfigFlags(FLAG_VSYNC_HINT);
     InitWindow(800, 600, "Battle Bomber");
-    SetTargetFPS(60);
     
     // Change to project root directory so asset paths work
     // Try to find project root by looking for src directory
@@ -23,125 +26,192 @@ Game::Game() : currentState(GameState::MENU), currentLevel(1),
         ChangeDirectory("../../../../..");
     }
     
+    // Always recording, the overlay and export only read the ring
+    Profiler::GetInstance()->SetEnabled(true);
+
     // Load textures when game starts
     LoadTextures();
 }
 
 Game::~Game() {
+    client.Disconnect();
     // Ensure raylib window closed (safe even if already closed)
     if (!WindowShouldClose()) CloseWindow();
     // Destroy texture manager singleton (its destructor unloads textures)
     TextureManager::DestroyInstance();
+    Profiler::DestroyInstance();
 }
 
 void Game::Run() {
     while (!WindowShouldClose()) {
-        Update();
+        TextureManager::GetInstance()->Update();
+        Update(GetFrameTime());
         Draw();
+        Profiler::GetInstance()->MarkFrame();
     }
+    levelManager.UnloadDrawResources();
     CloseWindow();
 }
 
 void Game::LoadTextures() {
     TextureManager* texManager = TextureManager::GetInstance();
     
-    texManager->LoadTexture("tank", "src/Assets/TankForward.png");
-    texManager->LoadTexture("bullet", "src/Assets/bullet.png");
-    texManager->LoadTexture("wall", "src/Assets/TileTexture.png");
-    texManager->LoadTexture("barrel", "src/Assets/Barrel.png");
-    texManager->LoadTexture("powerup", "src/Assets/PowerUp.png");
-    texManager->LoadTexture("exit", "src/Assets/ExitSprite.png");
-    texManager->LoadTexture("destructible", "src/Assets/DestructibeBlock.png");
+    // Decoded on worker threads while the menu is already up; Run() calls
+    // TextureManager::Update each frame, which packs and uploads the atlas
+    // once the last image is in
+    texManager->QueueTexture("tank", "src/Assets/TankForward.png");
+    texManager->QueueTexture("bullet", "src/Assets/bullet.png");
+    texManager->QueueTexture("wall", "src/Assets/TileTexture.png");
+    texManager->QueueTexture("barrel", "src/Assets/Barrel.png");
+    texManager->QueueTexture("powerup", "src/Assets/PowerUp.png");
+    texManager->QueueTexture("exit", "src/Assets/ExitSprite.png");
+    texManager->QueueTexture("destructible", "src/Assets/DestructibeBlock.png");
+    texManager->StartLoading();
 }
 // Don't forget to clean up in destructor or when closing
 
-void Game::Update() {
+SimInput Game::ReadInput() const {
+    // Handle player input - movement (WASD and arrow keys)
+    SimInput input = {{0, 0}, false};
+    if (IsKeyDown(KEY_UP) || IsKeyDown(KEY_W)) {
+        input.move.y = -1;
+    }
+    if (IsKeyDown(KEY_DOWN) || IsKeyDown(KEY_S)) {
+        input.move.y = 1;
+    }
+    if (IsKeyDown(KEY_LEFT) || IsKeyDown(KEY_A)) {
+        input.move.x = -1;
+    }
+    if (IsKeyDown(KEY_RIGHT) || IsKeyDown(KEY_D)) {
+        input.move.x = 1;
+    }
+    
+    // Normalize diagonal movement
+    if (input.move.x != 0 && input.move.y != 0) {
+        input.move.x *= 0.707f; // 1/sqrt(2) for normalized diagonal
+        input.move.y *= 0.707f;
+    }
+    
+    // Handle shooting (spacebar)
+    input.shoot = IsKeyPressed(KEY_SPACE);
+    return input;
+}
+
+void Game::ScanLevels() {
+    levelFiles.clear();
+
+    FilePathList files = LoadDirectoryFilesEx("levels", ".bbl", false);
+    for (unsigned int i = 0; i < files.count; i++) {
+        levelFiles.push_back(files.paths[i]);
+    }
+    UnloadDirectoryFiles(files);
+
+    std::sort(levelFiles.begin(), levelFiles.end());
+    // Number keys 1-9 select a level
+    if (levelFiles.size() > 9) {
+        levelFiles.resize(9);
+    }
+}
+
+void Game::Update(float frameTime) {
+    PROFILE_ZONE("Game::Update");
+
+    // Profiler overlay and export work on every screen
+    if (IsKeyPressed(KEY_F2)) {
+        showProfiler = !showProfiler;
+    }
+    if (IsKeyPressed(KEY_F3)) {
+        ExportProfile();
+    }
+
     switch (currentState) {
         case GameState::MENU:
             menu.Update();
             if (menu.ShouldStartGame()) {
+                ScanLevels();
                 currentState = GameState::LEVEL_SELECT;
             }
             if (menu.ShouldExit()) {
+                levelManager.UnloadDrawResources();
                 CloseWindow();
             }
             break;
             
         case GameState::LEVEL_SELECT:
-            if (IsKeyPressed(KEY_ONE)) {
-                StartGame(1);
-            } else if (IsKeyPressed(KEY_TWO)) {
-                StartGame(2);
-            } else if (IsKeyPressed(KEY_ESCAPE)) {
+            for (int i = 0; i < (int)levelFiles.size(); i++) {
+                if (IsKeyPressed(KEY_ONE + i)) {
+                    StartGame(i);
+                    break;
+                }
+            }
+            if (IsKeyPressed(KEY_ESCAPE)) {
                 currentState = GameState::MENU;
             }
             break;
             
-        case GameState::PLAYING: {
-            gameTime += GetFrameTime();
-            
-            // Handle player input - movement (WASD and arrow keys)
-            Vector2 input = {0, 0};
-            if (IsKeyDown(KEY_UP) || IsKeyDown(KEY_W)) {
-                input.y = -1;
-            }
-            if (IsKeyDown(KEY_DOWN) || IsKeyDown(KEY_S)) {
-                input.y = 1;
-            }
-            if (IsKeyDown(KEY_LEFT) || IsKeyDown(KEY_A)) {
-                input.x = -1;
-            }
-            if (IsKeyDown(KEY_RIGHT) || IsKeyDown(KEY_D)) {
-                input.x = 1;
-            }
-            
-            // Normalize diagonal movement
-            if (input.x != 0 && input.y != 0) {
-                input.x *= 0.707f; // 1/sqrt(2) for normalized diagonal
-                input.y *= 0.707f;
-            }
-            
-            // Check collision before moving - store current position
-            // use LevelManager's player via pointer (must be set by StartGame)
-            if (!player) break;
-            Vector2 currentPos = player->GetPosition();
-            Vector2 newPos = {
-                currentPos.x + input.x * player->GetSpeed(),
-                currentPos.y + input.y * player->GetSpeed()
-            };
-            
-            // Only move if new position doesn't collide with obstacles
-            if (!levelManager.CheckCollisionWithObstacles(newPos)) {
-                player->Move(input);
-            } else {
-                // Still update direction even if we can't move
-                if (input.x != 0 || input.y != 0) {
-                    player->SetDirection(input);
+        case GameState::CONNECTING:
+            // Nothing to draw until the first snapshot is on the level
+            client.Update(frameTime);
+            if (client.GetState() == ClientState::DISCONNECTED) {
+                std::cout << "Failed to join the match: " << client.GetError() << std::endl;
+                LeaveRemote();
+            } else if (client.HasSnapshot()) {
+                if (client.ApplyTo(levelManager)) {
+                    accumulator = 0;
+                    queuedShot = false;
+                    currentState = GameState::PLAYING;
+                } else {
+                    std::cout << "Failed to join the match: " << client.GetError() << std::endl;
+                    LeaveRemote();
                 }
+            } else if (IsKeyPressed(KEY_ESCAPE)) {
+                LeaveRemote();
             }
-            
-            // Handle shooting (spacebar)
-            if (IsKeyPressed(KEY_SPACE)) {
-                player->Shoot();
+            break;
+
+        case GameState::PLAYING: {
+            if (remote) {
+                UpdateRemote(frameTime);
+                break;
             }
-            
+
             // Toggle debug mode with F1
             if (IsKeyPressed(KEY_F1)) {
                 debugMode = !debugMode;
             }
             
-            // Update level (this updates the LevelManager's player and checks bullets)
-            levelManager.Update();
-            
-            // Check if time ran out
-            if (gameTime >= levelTimeLimit) {
-                currentState = GameState::GAME_OVER;
+            // Step the simulation in fixed ticks, carrying the remainder over
+            // to the next frame (moves the player, updates bullets and tiles)
+            SimInput input = ReadInput();
+            // A key press may land on a frame that runs no tick, keep it until one does
+            queuedShot = queuedShot || input.shoot;
+            accumulator += std::min(frameTime, MAX_FRAME_TIME);
+            while (accumulator >= SIM_TIMESTEP) {
+                if (replaying) {
+                    // Recorded input replaces the keyboard, the session
+                    // ended here if the recording has no more ticks
+                    if (!replay.Next(input)) {
+                        EndSession();
+                        currentState = GameState::MENU;
+                        break;
+                    }
+                } else {
+                    input.shoot = queuedShot;
+                    replay.Record(input);
+                }
+                levelManager.Update(input, SIM_TIMESTEP);
+                queuedShot = false;
+                accumulator -= SIM_TIMESTEP;
             }
+            if (currentState != GameState::PLAYING) break;
             
             CheckWinCondition();
             CheckLoseCondition();
             
             if (IsKeyPressed(KEY_ESCAPE)) {
+                // Leaving a replay early proves nothing, just drop it
+                if (!replaying) EndSession();
+                replaying = false;
                 currentState = GameState::MENU;
             }
             break;
@@ -156,7 +226,65 @@ void Game::Update() {
     }
 }
 
+void Game::UpdateRemote(float frameTime) {
+    if (IsKeyPressed(KEY_F1)) {
+        debugMode = !debugMode;
+    }
+
+    // Read first so the inputs carry the newest snapshot ack
+    client.Update(frameTime);
+
+    // Input still goes out at the simulation rate, the server runs one
+    // tick per input it gets
+    SimInput input = ReadInput();
+    queuedShot = queuedShot || input.shoot;
+    accumulator += std::min(frameTime, MAX_FRAME_TIME);
+    while (accumulator >= SIM_TIMESTEP) {
+        input.shoot = queuedShot;
+        client.SendInput(input);
+        queuedShot = false;
+        accumulator -= SIM_TIMESTEP;
+    }
+
+    if (!client.ApplyTo(levelManager) || client.GetState() == ClientState::DISCONNECTED) {
+        std::cout << "Left the match: " << client.GetError() << std::endl;
+        LeaveRemote();
+        return;
+    }
+    // The server decides wins and losses and starts the next match itself
+    levelManager.UpdateRemoteView(frameTime);
+
+    if (IsKeyPressed(KEY_ESCAPE)) {
+        LeaveRemote();
+    }
+}
+
+void Game::LeaveRemote() {
+    client.Disconnect();
+    remote = false;
+    currentState = GameState::MENU;
+}
+
+Camera2D Game::GetCamera(float alpha) const {
+    // Follow the player but never show anything past the level edge. Levels
+    // smaller than the window are centred.
+    Rectangle world = levelManager.GetWorldBounds();
+    Vector2 half = {GetScreenWidth() / 2.0f, GetScreenHeight() / 2.0f};
+    Vector2 target = levelManager.GetPlayerPosition(alpha);
+    if (remote && levelManager.GetEntities().IsAlive(client.GetOwnTank())) {
+        target = levelManager.GetEntityPosition(client.GetOwnTank(), alpha);
+    }
+
+    Camera2D camera = {};
+    camera.offset = half;
+    camera.zoom = 1.0f;
+    camera.target.x = world.width <= half.x * 2 ? world.width / 2 : std::clamp(target.x, half.x, world.width - half.x);
+    camera.target.y = world.height <= half.y * 2 ? world.height / 2 : std::clamp(target.y, half.y, world.height - half.y);
+    return camera;
+}
+
 void Game::Draw() {
+    PROFILE_ZONE("Game::Draw");
     BeginDrawing();
 
     // Set background color based on game state
@@ -166,6 +294,7 @@ void Game::Draw() {
             backgroundColor = BLACK;
             break;
         case GameState::LEVEL_SELECT:
+        case GameState::CONNECTING:
         case GameState::PLAYING:
         case GameState::GAME_OVER:
         case GameState::WIN:
@@ -177,26 +306,63 @@ void Game::Draw() {
     switch (currentState) {
         case GameState::MENU:
             menu.Draw();
+            if (TextureManager::GetInstance()->IsLoading()) {
+                float progress = TextureManager::GetInstance()->GetLoadProgress();
+                DrawText(TextFormat("Loading assets... %d%%", (int)(progress * 100)), 10, 570, 20, GRAY);
+            }
             break;
             
         case GameState::LEVEL_SELECT:
             DrawText("SELECT LEVEL", 300, 200, 30, WHITE);
-            DrawText("1 - Level 1", 350, 250, 20, WHITE);
-            DrawText("2 - Level 2", 350, 280, 20, WHITE);
-            DrawText("ESC - Back to Menu", 320, 350, 20, WHITE);
+            if (levelFiles.empty()) {
+                DrawText("No levels found in levels/", 280, 250, 20, WHITE);
+            }
+            for (int i = 0; i < (int)levelFiles.size(); i++) {
+                DrawText(TextFormat("%d - %s", i + 1, GetFileNameWithoutExt(levelFiles[i].c_str())),
+                         350, 250 + i * 30, 20, WHITE);
+            }
+            DrawText("ESC - Back to Menu", 320, 270 + (int)std::max<size_t>(levelFiles.size(), 1) * 30, 20, WHITE);
             break;
 
-        case GameState::PLAYING:
-            levelManager.DrawDebug(debugMode);
-            player->DrawDebug(debugMode);
+        case GameState::CONNECTING:
+            DrawText("JOINING MATCH...", 290, 250, 30, WHITE);
+            DrawText("ESC - Back to Menu", 320, 320, 20, WHITE);
+            break;
+
+        case GameState::PLAYING: {
+            // Blend positions by how far we are into the next tick, or
+            // between the two newest snapshots of a server's match
+            float alpha = remote ? client.GetInterpolation() : accumulator / SIM_TIMESTEP;
+            Camera2D camera = GetCamera(alpha);
+            Vector2 viewMin = GetScreenToWorld2D({0, 0}, camera);
+            Rectangle view = {viewMin.x, viewMin.y, (float)GetScreenWidth(), (float)GetScreenHeight()};
+
+            BeginMode2D(camera);
+            levelManager.DrawDebug(debugMode, view);
+            levelManager.DrawEntities(debugMode, alpha, view);
+            EndMode2D();
 
             // Draw HUD
-            DrawText(TextFormat("Time: %.1f", levelTimeLimit - gameTime), 10, 10, 20, WHITE);
-            DrawText(TextFormat("Level: %d", currentLevel), 10, 40, 20, WHITE);
+            float timeRemaining = remote ? client.GetTimeRemaining() : levelManager.GetTimeRemaining();
+            DrawText(TextFormat("Time: %.1f", timeRemaining), 10, 10, 20, WHITE);
+            if (remote) {
+                DrawText(TextFormat("Online: %d ms", (int)(client.GetInputLatency() * 1000)), 10, 40, 20, WHITE);
+                // The server starts the next match by itself
+                if (client.GetStatus() == LevelStatus::WON) {
+                    DrawText("MATCH WON!", 300, 250, 40, GREEN);
+                } else if (client.GetStatus() == LevelStatus::LOST) {
+                    DrawText("MATCH LOST", 300, 250, 40, RED);
+                }
+            } else if (replaying) {
+                DrawText("REPLAY", 10, 40, 20, YELLOW);
+            } else {
+                DrawText(TextFormat("Level: %d", currentLevel + 1), 10, 40, 20, WHITE);
+            }
             if (debugMode) {
                 DrawText("DEBUG MODE (F1 to toggle)", 10, 70, 20, RED);
             }
             break;
+        }
 
         case GameState::GAME_OVER:
             DrawText("GAME OVER", 300, 250, 40, RED);
@@ -209,28 +375,97 @@ void Game::Draw() {
             break;
     }
     
+    if (showProfiler) {
+        Profiler::GetInstance()->DrawOverlay(430, 10);
+    }
+
     EndDrawing();
 }
 
 void Game::StartGame(int level) {
+    levelManager.SetRemoteView(false);
+    if (!levelManager.LoadLevel(levelFiles[level])) {
+        // Stay on the level select screen, LoadLevel has logged why
+        return;
+    }
     currentLevel = level;
-    levelManager.LoadLevel(level);
-    // point Game::player to LevelManager's player instance so bullets and input operate on same object
-    player = &levelManager.GetPlayer();
-    gameTime = 0;
-    levelCompleted = false;
+    accumulator = 0;
+    queuedShot = false;
+    replaying = false;
+    replay.Begin(levelFiles[level]);
     currentState = GameState::PLAYING;
 }
 
+bool Game::StartReplay(const std::string& path) {
+    std::string error;
+    if (!replay.Load(path, error)) {
+        std::cout << "Failed to load replay: " << error << std::endl;
+        return false;
+    }
+    levelManager.SetRemoteView(false);
+    if (!levelManager.LoadLevel(replay.GetLevelPath())) {
+        return false;
+    }
+    currentLevel = 0;
+    accumulator = 0;
+    queuedShot = false;
+    replaying = true;
+    currentState = GameState::PLAYING;
+    return true;
+}
+
+bool Game::StartRemote(const std::string& address) {
+    std::string error;
+    if (!client.Connect(address, error)) {
+        std::cout << "Failed to connect: " << error << std::endl;
+        return false;
+    }
+    remote = true;
+    replaying = false;
+    currentState = GameState::CONNECTING;
+    return true;
+}
+
+void Game::ExportProfile() {
+    Profiler* profiler = Profiler::GetInstance();
+    std::string error;
+    if (profiler->ExportCsv("profile.csv", error) && profiler->ExportChromeTrace("profile.json", error)) {
+        std::cout << "Saved profile.csv and profile.json" << std::endl;
+    } else {
+        std::cout << "Failed to export profile: " << error << std::endl;
+    }
+}
+
+void Game::EndSession() {
+    if (replaying) {
+        replaying = false;
+        if (levelManager.GetStateHash() == replay.GetEndHash()) {
+            std::cout << "Replay matches the recorded end state" << std::endl;
+        } else {
+            std::cout << "Replay diverged from the recorded end state" << std::endl;
+        }
+        return;
+    }
+
+    replay.Finish(levelManager.GetStateHash());
+    std::string error;
+    if (replay.Save("last_replay.bbr", error)) {
+        std::cout << "Saved replay to last_replay.bbr (" << replay.GetTickCount() << " ticks)" << std::endl;
+    } else {
+        std::cout << "Failed to save replay: " << error << std::endl;
+    }
+}
+
 void Game::CheckWinCondition() {
-    if (!levelCompleted && (levelManager.AreAllDestructiblesDestroyed() || levelManager.IsPlayerOnExit())) {
-        levelCompleted = true;
+    if (levelManager.GetStatus() == LevelStatus::WON) {
+        EndSession();
         currentState = GameState::WIN;
     }
 }
 
 void Game::CheckLoseCondition() {
-    if (levelManager.IsPlayerDead()) {
+    if (levelManager.GetStatus() == LevelStatus::LOST) {
+        EndSession();
         currentState = GameState::GAME_OVER;
     }
 }
@@ -1,39 +1,68 @@
 #ifndef GAME_H
 #define GAME_H
 
-#include "Player.h"
 #include "LevelManager.h"
+#include "MatchClient.h"
 #include "Menu.h"
+#include "Profiler.h"
+#include "Replay.h"
 #include "TextureManager.h"
+#include <string>
+#include <vector>
 
 enum class GameState {
     MENU,
     PLAYING,
+    CONNECTING,
     LEVEL_SELECT,
     GAME_OVER,
     WIN
 };
 
+// Longest frame we try to catch up on, avoids a spiral after a stall
+const float MAX_FRAME_TIME = 0.25f;
+
 class Game {
 private:
     GameState currentState;
     Menu menu;
     LevelManager levelManager;
-    Player* player; 
     int currentLevel;
-    float gameTime;
-    float levelTimeLimit;
-    bool levelCompleted;
+    std::vector<std::string> levelFiles;
     bool debugMode;
+    bool showProfiler;
+    float accumulator;
+    bool queuedShot;
+    // Every session is recorded into replay; when replaying it supplies
+    // the input instead of the keyboard
+    Replay replay;
+    bool replaying;
+    // Playing in a MatchServer's match, the level only shows its snapshots
+    MatchClient client;
+    bool remote;
     void LoadTextures();
+    SimInput ReadInput() const;
+    void ScanLevels();
+    // Saves the recording, or checks the replayed end state
+    void EndSession();
+    void ExportProfile();
+    // One frame of a server's match: sends input, shows the newest state
+    void UpdateRemote(float frameTime);
+    void LeaveRemote();
+    Camera2D GetCamera(float alpha) const;
 
 public:
     Game();
     ~Game(); 
     void Run();
-    void Update();
+    void Update(float frameTime);
     void Draw();
+    // level is an index into levelFiles
     void StartGame(int level);
+    // Plays a .bbr recording in real time instead of reading the keyboard
+    bool StartReplay(const std::string& path);
+    // Joins a bomber_server match at "host:port"
+    bool StartRemote(const std::string& address);
     void CheckWinCondition();
     void CheckLoseCondition();
 };
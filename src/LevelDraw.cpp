@@ -0,0 +1,274 @@
+// Drawing for LevelManager and BulletPool. Not part of bomber_sim, so the
+// headless tools run matches without a TextureManager; the atlas ids of
+// what the simulation shows are looked up here, on the first draw.
+
+#include "LevelManager.h"
+#include "Profiler.h"
+#include "TextureManager.h"
+#include <algorithm>
+#include <math.h>
+
+struct SimSprites {
+    SpriteId tiles[TILE_TYPE_COUNT];  // INVALID_SPRITE for tiles drawn as nothing
+    SpriteId entities[ENTITY_SPRITE_COUNT];
+    SpriteId bullet;
+};
+
+static SimSprites ResolveSimSprites() {
+    TextureManager* texManager = TextureManager::GetInstance();
+    SimSprites sprites;
+    for (SpriteId& sprite : sprites.tiles) {
+        sprite = INVALID_SPRITE;
+    }
+    sprites.tiles[(int)TileType::WALL] = texManager->GetSpriteId("wall");
+    sprites.tiles[(int)TileType::DESTRUCTIBLE] = texManager->GetSpriteId("destructible");
+    sprites.tiles[(int)TileType::BARREL] = texManager->GetSpriteId("barrel");
+    sprites.tiles[(int)TileType::POWER_UP] = texManager->GetSpriteId("powerup");
+    sprites.tiles[(int)TileType::EXIT_POINT] = texManager->GetSpriteId("exit");
+    sprites.entities[(int)EntitySprite::TANK] = texManager->GetSpriteId("tank");
+    sprites.bullet = texManager->GetSpriteId("bullet");
+    return sprites;
+}
+
+// Only the main thread draws, so the unlocked GetSpriteId is safe here
+static const SimSprites& GetSimSprites() {
+    static const SimSprites sprites = ResolveSimSprites();
+    return sprites;
+}
+
+void LevelManager::Draw() {
+    DrawDebug(false, GetWorldBounds());
+}
+
+void LevelManager::DrawDebug(bool debugMode, Rectangle view) {
+    PROFILE_ZONE("LevelManager::DrawDebug");
+    drawFrame++;
+    FlushDirtyTiles(debugMode);
+
+    // Only the resident chunks under the view, each from its cached layer
+    TileRange visible = GetTilesInRect(view);
+    if (visible.minX > visible.maxX || visible.minY > visible.maxY) return;
+
+    for (int cy = visible.minY >> CHUNK_SHIFT; cy <= visible.maxY >> CHUNK_SHIFT; cy++) {
+        for (int cx = visible.minX >> CHUNK_SHIFT; cx <= visible.maxX >> CHUNK_SHIFT; cx++) {
+            int chunk = cy * chunksX + cx;
+            if (chunkSlots[chunk] < 0) continue;
+
+            ChunkLayer& layer = AcquireChunkLayer(chunk, debugMode);
+            // Render textures are stored bottom-up, so flip the source rect
+            Rectangle source = {0, 0, (float)layer.target.texture.width, -(float)layer.target.texture.height};
+            Rectangle origin = GetTileRect(cx * CHUNK_SIZE, cy * CHUNK_SIZE);
+            DrawTextureRec(layer.target.texture, source, {origin.x, origin.y}, WHITE);
+        }
+    }
+
+    // Exploding tiles are drawn on top with their offset
+    for (const TileAnimation& anim : activeAnimations) {
+        Rectangle drawRect = GetTileRect(anim.index % width, anim.index / width);
+        if (!CheckCollisionRecs(drawRect, view)) continue;
+
+        drawRect.x += anim.offset; // Apply animation offset
+        DrawTile(TileAt(anim.index % width, anim.index / width)->type, drawRect, debugMode);
+    }
+}
+
+void LevelManager::DrawEntities(bool debugMode, float alpha, Rectangle view) {
+    PROFILE_ZONE("LevelManager::DrawEntities");
+    const TextureManager* texManager = TextureManager::GetInstance();
+    const SimSprites& sprites = GetSimSprites();
+    const ComponentArray<Appearance>& appearances = entities.Appearances();
+    for (size_t i = 0; i < appearances.Size(); i++) {
+        uint32_t owner = appearances.Owner(i);
+        const Transform* transform = entities.Transforms().Find(owner);
+        const Collider* collider = entities.Colliders().Find(owner);
+        if (!transform || !collider) continue;
+
+        // Blend between the previous and current tick for smooth rendering
+        Vector2 drawPos = {
+            transform->previousPosition.x + (transform->position.x - transform->previousPosition.x) * alpha,
+            transform->previousPosition.y + (transform->position.y - transform->previousPosition.y) * alpha
+        };
+        Vector2 size = collider->size;
+        Rectangle rect = {drawPos.x - size.x/2, drawPos.y - size.y/2, size.x, size.y};
+        if (!CheckCollisionRecs(rect, view)) continue;
+
+        if (!debugMode) {
+            // Calculate rotation based on direction
+            Vector2 direction = transform->direction;
+            float rotation = 0.0f;
+            if (direction.x == 1) rotation = 90.0f;
+            else if (direction.x == -1) rotation = 270.0f;
+            else if (direction.y == -1) rotation = 0.0f;
+            else if (direction.y == 1) rotation = 180.0f;
+
+            Rectangle destRect = {drawPos.x, drawPos.y, size.x, size.y};
+            Vector2 origin = {size.x/2, size.y/2};
+            texManager->DrawSprite(sprites.entities[(int)appearances[i].sprite], destRect, origin, rotation, appearances[i].tint);
+        } else {
+            // Draw hitbox, blue for the player's side
+            DrawRectangleRec(rect, collider->team == TEAM_PLAYER ? BLUE : MAROON);
+            DrawRectangleLinesEx(rect, 2.0f, BLACK);
+        }
+    }
+
+    bullets.Draw(debugMode, alpha);
+}
+
+ChunkLayer& LevelManager::AcquireChunkLayer(int chunk, bool debugMode) {
+    unsigned int atlasId = TextureManager::GetInstance()->GetAtlas().id;
+
+    int found = FindChunkLayer(chunk);
+    if (found < 0) {
+        // Take a free slot, or the one that went longest without being drawn
+        found = 0;
+        for (int i = 0; i < MAX_CHUNK_LAYERS; i++) {
+            if (chunkLayers[i].chunk < 0) {
+                found = i;
+                break;
+            }
+            if (chunkLayers[i].lastUsed < chunkLayers[found].lastUsed) {
+                found = i;
+            }
+        }
+        chunkLayers[found].chunk = chunk;
+        PaintChunkLayer(chunkLayers[found], debugMode);
+    } else if (chunkLayers[found].debug != debugMode || chunkLayers[found].atlas != atlasId) {
+        // Repaint after a debug toggle or a new atlas
+        PaintChunkLayer(chunkLayers[found], debugMode);
+    }
+
+    chunkLayers[found].lastUsed = drawFrame;
+    return chunkLayers[found];
+}
+
+void LevelManager::PaintChunkLayer(ChunkLayer& layer, bool debugMode) {
+    int cx = layer.chunk % chunksX;
+    int cy = layer.chunk / chunksX;
+    int firstX = cx * CHUNK_SIZE;
+    int firstY = cy * CHUNK_SIZE;
+    int tilesX = std::min(CHUNK_SIZE, width - firstX);
+    int tilesY = std::min(CHUNK_SIZE, height - firstY);
+
+    // Edge chunks are smaller, only reallocate when the size changes
+    if (layer.target.texture.width != tilesX * tileSize ||
+        layer.target.texture.height != tilesY * tileSize) {
+        if (layer.target.id != 0) {
+            UnloadRenderTexture(layer.target);
+        }
+        layer.target = LoadRenderTexture(tilesX * tileSize, tilesY * tileSize);
+    }
+
+    // Tiles are painted in chunk-local coordinates
+    BeginTextureMode(layer.target);
+    ClearBackground(BLANK);
+    for (int y = 0; y < tilesY; y++) {
+        for (int x = 0; x < tilesX; x++) {
+            const Tile* tile = TileAt(firstX + x, firstY + y);
+            if (!tile || (tile->flags & (TILE_DESTROYED | TILE_ANIMATING))) continue;
+
+            DrawTile(tile->type, GetTileRect(x, y), debugMode);
+        }
+    }
+    EndTextureMode();
+
+    layer.debug = debugMode;
+    layer.atlas = TextureManager::GetInstance()->GetAtlas().id;
+}
+
+void LevelManager::FlushDirtyTiles(bool debugMode) {
+    // Only the changed cells: clear each one in its chunk's layer and repaint
+    // it if it still has something static to show
+    for (int index : dirtyTiles) {
+        int x = index % width;
+        int y = index / width;
+        int found = FindChunkLayer((y >> CHUNK_SHIFT) * chunksX + (x >> CHUNK_SHIFT));
+        if (found < 0) continue;
+
+        Rectangle rect = GetTileRect(x & (CHUNK_SIZE - 1), y & (CHUNK_SIZE - 1));
+        BeginTextureMode(chunkLayers[found].target);
+        BeginScissorMode((int)rect.x, (int)rect.y, (int)rect.width, (int)rect.height);
+        ClearBackground(BLANK);
+        EndScissorMode();
+
+        const Tile* tile = TileAt(x, y);
+        if (tile && !(tile->flags & (TILE_DESTROYED | TILE_ANIMATING))) {
+            DrawTile(tile->type, rect, debugMode);
+        }
+        EndTextureMode();
+    }
+    dirtyTiles.clear();
+}
+
+void LevelManager::UnloadDrawResources() {
+    for (ChunkLayer& layer : chunkLayers) {
+        if (layer.target.id != 0) {
+            UnloadRenderTexture(layer.target);
+        }
+        layer = ChunkLayer{-1, RenderTexture2D{}, false, 0, 0};
+    }
+}
+
+void LevelManager::DrawTile(TileType type, Rectangle rect, bool debugMode) {
+    if (debugMode) {
+        // Draw hitboxes instead of sprites
+        Color hitboxColor = RED;
+        switch (type) {
+            case TileType::WALL:
+                hitboxColor = GRAY;
+                break;
+            case TileType::BARREL:
+                hitboxColor = RED;
+                break;
+            case TileType::DESTRUCTIBLE:
+                hitboxColor = ORANGE;
+                break;
+            case TileType::POWER_UP:
+                hitboxColor = YELLOW;
+                break;
+            case TileType::EXIT_POINT:
+                hitboxColor = GREEN;
+                break;
+            default:
+                hitboxColor = DARKGRAY;
+                break;
+        }
+        DrawRectangleRec(rect, hitboxColor);
+        DrawRectangleLinesEx(rect, 2.0f, BLACK);
+    } else {
+        // Draw sprites normally
+        SpriteId sprite = GetSimSprites().tiles[(int)type];
+        if (sprite != INVALID_SPRITE) {
+            TextureManager::GetInstance()->DrawSprite(sprite, rect, {0, 0}, 0, WHITE);
+        }
+    }
+}
+
+void BulletPool::Draw(bool debugMode, float alpha) const {
+    const TextureManager* texManager = TextureManager::GetInstance();
+
+    for (size_t i = 0; i < count; i++) {
+        // Blend between the previous and current tick for smooth rendering
+        Vector2 drawPos = {
+            prevX[i] + (posX[i] - prevX[i]) * alpha,
+            prevY[i] + (posY[i] - prevY[i]) * alpha
+        };
+        bool powerUp = flags[i] & BULLET_POWER_UP;
+
+        if (debugMode) {
+            // Draw hitbox instead of sprite
+            Rectangle hitbox = {drawPos.x - 4, drawPos.y - 4, 8, 8};
+            Color hitboxColor = powerUp ? YELLOW : RED;
+            DrawRectangleRec(hitbox, hitboxColor);
+            DrawRectangleLinesEx(hitbox, 1.0f, BLACK);
+        } else {
+            // Calculate rotation based on velocity
+            float rotation = atan2(velY[i], velX[i]) * RAD2DEG;
+
+            Rectangle destRect = {drawPos.x, drawPos.y, 8, 8}; // Adjust size as needed
+            Vector2 origin = {4, 4}; // Half of the destRect size
+
+            Color tint = powerUp ? YELLOW : WHITE;
+            texManager->DrawSprite(GetSimSprites().bullet, destRect, origin, rotation, tint);
+        }
+    }
+}
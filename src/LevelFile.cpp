@@ -0,0 +1,119 @@
+#include "LevelFile.h"
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+LevelFile::LevelFile() : data(nullptr), size(0), fileHandle(nullptr), mappingHandle(nullptr) {}
+#else
+LevelFile::LevelFile() : data(nullptr), size(0) {}
+#endif
+
+LevelFile::~LevelFile() {
+    Close();
+}
+
+bool LevelFile::Open(const std::string& path, std::string& error) {
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        error = "cannot open " + path;
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        error = "cannot read size of " + path;
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        error = "cannot map " + path;
+        return false;
+    }
+    fileHandle = file;
+    mappingHandle = mapping;
+    data = (const unsigned char*)view;
+    size = (size_t)fileSize.QuadPart;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open " + path;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        error = "cannot read size of " + path;
+        return false;
+    }
+    void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps the file alive on its own
+    close(fd);
+    if (view == MAP_FAILED) {
+        error = "cannot map " + path;
+        return false;
+    }
+    data = (const unsigned char*)view;
+    size = (size_t)info.st_size;
+#endif
+
+    if (!ValidateLevel(data, size, error)) {
+        error = path + ": " + error;
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void LevelFile::Close() {
+    if (!data) return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle((HANDLE)mappingHandle);
+    CloseHandle((HANDLE)fileHandle);
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+#else
+    munmap((void*)data, size);
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+void LevelFile::Swap(LevelFile& other) {
+    std::swap(data, other.data);
+    std::swap(size, other.size);
+#ifdef _WIN32
+    std::swap(fileHandle, other.fileHandle);
+    std::swap(mappingHandle, other.mappingHandle);
+#endif
+}
+
+bool LevelFile::IsOpen() const {
+    return data != nullptr;
+}
+
+const LevelHeader& LevelFile::GetHeader() const {
+    return *(const LevelHeader*)data;
+}
+
+const Tile* LevelFile::GetTiles() const {
+    return (const Tile*)(data + GetHeader().headerSize);
+}
@@ -0,0 +1,37 @@
+#ifndef LEVELFILE_H
+#define LEVELFILE_H
+
+#include "LevelFormat.h"
+#include <string>
+
+// A .bbl file mapped read-only into memory. The tiles are only read, when
+// chunks are copied out of them; play changes those copies, never the
+// mapping, so its pages stay shared with the page cache.
+class LevelFile {
+private:
+    const unsigned char* data;
+    size_t size;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+
+public:
+    LevelFile();
+    ~LevelFile();
+    LevelFile(const LevelFile&) = delete;
+    LevelFile& operator=(const LevelFile&) = delete;
+
+    // Closes whatever was open first, so a failed Open leaves it closed.
+    // Open into a separate LevelFile and Swap to keep the old mapping
+    // until the new one is known to be good.
+    bool Open(const std::string& path, std::string& error);
+    void Close();
+    void Swap(LevelFile& other);
+    bool IsOpen() const;
+
+    const LevelHeader& GetHeader() const;
+    const Tile* GetTiles() const;
+};
+
+#endif
@@ -0,0 +1,46 @@
+#include "LevelFormat.h"
+#include <cstring>
+
+bool ValidateLevel(const void* data, size_t size, std::string& error) {
+    if (size < sizeof(LevelHeader)) {
+        error = "file too small for a level header";
+        return false;
+    }
+
+    LevelHeader header;
+    std::memcpy(&header, data, sizeof(header));
+
+    if (std::memcmp(header.magic, LEVEL_MAGIC, sizeof(LEVEL_MAGIC)) != 0) {
+        error = "not a level file";
+        return false;
+    }
+    if (header.version != LEVEL_VERSION) {
+        error = "unsupported level version " + std::to_string(header.version);
+        return false;
+    }
+    if (header.headerSize < sizeof(LevelHeader)) {
+        error = "bad header size";
+        return false;
+    }
+    if (header.width == 0 || header.height == 0 ||
+        header.width > (uint32_t)MAX_LEVEL_SIZE || header.height > (uint32_t)MAX_LEVEL_SIZE) {
+        error = "bad level dimensions";
+        return false;
+    }
+    if (header.spawnX >= header.width || header.spawnY >= header.height ||
+        header.exitX >= header.width || header.exitY >= header.height) {
+        error = "spawn or exit outside the level";
+        return false;
+    }
+    if (header.destructibles > header.width * header.height) {
+        error = "more destructibles than cells";
+        return false;
+    }
+
+    size_t expected = header.headerSize + (size_t)header.width * header.height * sizeof(Tile);
+    if (size != expected) {
+        error = "file size does not match its dimensions";
+        return false;
+    }
+    return true;
+}
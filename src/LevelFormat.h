@@ -0,0 +1,67 @@
+#ifndef LEVELFORMAT_H
+#define LEVELFORMAT_H
+
+// Tile records and the .bbl level file layout. Kept free of raylib so the
+// level tools build without it (and so LevelFile.cpp can include the
+// platform headers, which clash with raylib names on Windows).
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+enum class TileType : uint8_t {
+    EMPTY,
+    WALL,
+    DESTRUCTIBLE,
+    BARREL,
+    POWER_UP,
+    SPAWN_POINT,
+    EXIT_POINT,
+    ENEMY_SPAWN  // an enemy tank starts here when the chunk first loads
+};
+
+// Type bytes from here up are not tiles
+const int TILE_TYPE_COUNT = 8;
+
+// Tile::flags bits
+const uint8_t TILE_DESTROYED = 1 << 0;
+const uint8_t TILE_ANIMATING = 1 << 1;
+
+// Two bytes per cell. The rect follows from the cell position and tileSize,
+// animation state lives in LevelManager::activeAnimations.
+struct Tile {
+    TileType type;
+    uint8_t flags;
+};
+
+// .bbl files, little-endian: a LevelHeader, then width * height Tile
+// records row by row. The records are the in-memory Tile layout, so a
+// mapped file is used as the level's tile array without parsing.
+const char LEVEL_MAGIC[4] = {'B', 'B', 'L', 'V'};
+const uint16_t LEVEL_VERSION = 1;
+const int MAX_LEVEL_SIZE = 4096; // cells per side
+
+struct LevelHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t headerSize;    // offset of the first tile record
+    uint32_t width;
+    uint32_t height;
+    uint32_t spawnX;        // cells
+    uint32_t spawnY;
+    uint32_t exitX;
+    uint32_t exitY;
+    uint32_t destructibles; // DESTRUCTIBLE tiles, so loading needs no scan
+};
+
+static_assert(sizeof(Tile) == 2, "Tile records are stored as-is in level files");
+static_assert(sizeof(LevelHeader) == 36, "LevelHeader is part of the file format");
+
+// Checks the header against the buffer size. Only the header is read, so
+// a huge map isn't paged in to open it; tile types and flags are checked
+// as chunks are copied out (LevelManager::CopySourceChunk). The
+// destructible count is trusted as written by bomber_levelc, a count
+// above the number of cells is refused.
+bool ValidateLevel(const void* data, size_t size, std::string& error);
+
+#endif
@@ -1,297 +1,1348 @@
 #include "LevelManager.h"
-#include "TextureManager.h"
+#include "Profiler.h"
 #include <iostream>
 #include <cmath>
+#include <algorithm>
+#include <cstring>
 
-LevelManager::LevelManager() : tileSize(40) {}
+LevelManager::LevelManager() : sourceTiles(nullptr), chunksX(0), chunksY(0), streamCenter(-1),
+                               detonationHead(0), barrelBlastRadius(BARREL_BLAST_RADIUS),
+                               powerUpBlastRadius(POWER_UP_BLAST_RADIUS), width(0), height(0),
+                               player(INVALID_ENTITY), flowFieldValid(false), remoteView(false),
+                               exitPoint{0, 0}, tileSize(40),
+                               elapsedTime(0), timeLimit(120.0f), status(LevelStatus::RUNNING), bulletCapacity(32),
+                               remainingDestructibles(0), playerDead(false), playerOnExit(false),
+                               drawFrame(0) {
+    for (ChunkLayer& layer : chunkLayers) {
+        layer = ChunkLayer{-1, RenderTexture2D{}, false, 0, 0};
+    }
+    restoreScratch.resize(CHUNK_TILES);
+}
 
-void LevelManager::LoadLevel(int levelNumber) {
-    currentLevel.clear();
-    
-    // Simple level design - 20x15 grid
-    int width = 20;
-    int height = 15;
-    
-    currentLevel.resize(height, std::vector<Tile>(width));
-    
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            Tile tile;
-            tile.rect = {x * tileSize * 1.0f, y * tileSize * 1.0f, tileSize * 1.0f, tileSize * 1.0f};
-            tile.destroyed = false;
-            tile.animating = false;
-            tile.animationTimer = 0.0f;
-            tile.animationOffset = 0.0f;
-            
-            // Border walls
-            if (x == 0 || y == 0 || x == width - 1 || y == height - 1) {
-                tile.type = TileType::WALL;
-            }
-            // Some destructible blocks
-            else if ((x + y) % 4 == 0 && levelNumber == 1) {
-                tile.type = TileType::DESTRUCTIBLE;
-            }
-            else if ((x * y) % 5 == 0 && levelNumber == 2) {
-                tile.type = TileType::DESTRUCTIBLE;
-            }
-            // Barrels
-            else if ((x + y) % 7 == 0) {
-                tile.type = TileType::BARREL;
-            }
-            // Power-up
-            else if (x == 5 && y == 5 && levelNumber == 1) {
-                tile.type = TileType::POWER_UP;
-            }
-            else if (x == 15 && y == 10 && levelNumber == 2) {
-                tile.type = TileType::POWER_UP;
-            }
-            else {
-                tile.type = TileType::EMPTY;
-            }
-            
-            // Set spawn and exit points
-            if (x == 1 && y == 1) {
-                tile.type = TileType::SPAWN_POINT;
-                player = Player({tile.rect.x + tileSize/2, tile.rect.y + tileSize/2});
-            }
-            if (x == width - 2 && y == height - 2) {
-                tile.type = TileType::EXIT_POINT;
-                exitPoint = {tile.rect.x + tileSize/2, tile.rect.y + tileSize/2};
-            }
-            
-            currentLevel[y][x] = tile;
+bool LevelManager::LoadLevel(const std::string& path) {
+    // sourceTiles still points into the current mapping, keep it until the
+    // new file has passed validation
+    std::string error;
+    LevelFile opened;
+    if (!opened.Open(path, error)) {
+        std::cout << "Failed to load level: " << error << std::endl;
+        return false;
+    }
+    levelFile.Swap(opened);
+
+    generatedTiles.clear();
+    sourceTiles = levelFile.GetTiles();
+    ResetLevelState(levelFile.GetHeader());
+    return true;
+}
+
+void LevelManager::LoadLevel(const LevelHeader& header, const Tile* levelTiles) {
+    levelFile.Close();
+    generatedTiles.assign(levelTiles, levelTiles + (size_t)header.width * header.height);
+    sourceTiles = generatedTiles.data();
+
+    // Don't trust hand-built headers with the count
+    LevelHeader counted = header;
+    counted.destructibles = 0;
+    for (const Tile& tile : generatedTiles) {
+        if (tile.type == TileType::DESTRUCTIBLE) {
+            counted.destructibles++;
         }
     }
+    ResetLevelState(counted);
+}
+
+void LevelManager::ResetLevelState(const LevelHeader& header) {
+    width = (int)header.width;
+    height = (int)header.height;
+    elapsedTime = 0;
+    status = LevelStatus::RUNNING;
+
+    activeAnimations.clear();
+    detonations.clear();
+    detonationHead = 0;
+    dirtyTiles.clear();
+    for (ChunkLayer& layer : chunkLayers) {
+        layer.chunk = -1;
+    }
+
+    // Start with nothing resident, the first UpdateStreaming pulls in the
+    // chunks around the spawn point
+    chunksX = (width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    chunksY = (height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    chunkSlots.assign((size_t)chunksX * chunksY, -1);
+    chunkPool.assign((size_t)MAX_RESIDENT_CHUNKS * CHUNK_TILES, Tile{TileType::EMPTY, 0});
+    slotChunks.assign(MAX_RESIDENT_CHUNKS, -1);
+    slotModified.assign(MAX_RESIDENT_CHUNKS, false);
+    modifiedChunks.clear();
+    streamCenter = -1;
+
+    // Keep the pool's memory unless the capacity changed
+    if (bullets.Capacity() != bulletCapacity) {
+        bullets = BulletPool(bulletCapacity);
+    } else {
+        bullets.Clear();
+    }
+
+    // Set spawn and exit points
+    Rectangle spawnRect = GetTileRect(header.spawnX, header.spawnY);
+    Rectangle exitRect = GetTileRect(header.exitX, header.exitY);
+    entities.Clear();
+    player = SpawnTank({spawnRect.x + tileSize/2, spawnRect.y + tileSize/2}, TEAM_PLAYER, PLAYER_HIT_POINTS);
+    exitPoint = {exitRect.x + tileSize/2, exitRect.y + tileSize/2};
+    flowFieldValid = false;
+
+    remainingDestructibles = (int)header.destructibles;
+    UpdateStreaming();
+    RefreshPlayerState();
 }
 
-void LevelManager::Update() {
-    player.Update();
+void LevelManager::Update(const SimInput& input, float dt) {
+    if (status != LevelStatus::RUNNING || remoteView) return;
+    PROFILE_ZONE("LevelManager::Update");
+
+    elapsedTime += dt;
+
+    UpdateStreaming();
+
+    // The input drives the player, other tanks keep whatever their
+    // controller set on their Velocity and Weapon
+    entities.Velocities().Find(player.index)->move = input.move;
+    entities.Weapons().Find(player.index)->trigger = input.shoot;
+
+    UpdatePathFollowers(dt);
+    UpdateMovement(dt);
+    UpdateWeapons(dt);
+    bullets.Update(dt, GetActiveBounds());
     CheckBulletCollisions();
+    CheckBulletHits();
+    // Most ticks have no blast pending, skip the call
+    if (detonationHead < detonations.size()) {
+        UpdateExplosions();
+    }
 
     // Update tile animations
-    UpdateTileAnimations();
+    UpdateTileAnimations(dt);
+
+    RemoveDeadEntities();
+    UpdateStatus();
+}
 
-    // Check if player reached exit (alternative win condition)
-    Vector2 playerPos = player.GetPosition();
-    if (CheckCollisionPointRec(playerPos, {exitPoint.x - 20, exitPoint.y - 20, 40, 40})) {
-        // Player reached exit - you could implement this as another win condition
+Entity LevelManager::SpawnTank(Vector2 position, uint8_t team, int hitPoints) {
+    Entity entity = entities.Create();
+    entities.Transforms().Add(entity.index, {position, position, {0, -1}});
+    entities.Velocities().Add(entity.index, {{0, 0}, TANK_SPEED});
+    entities.Colliders().Add(entity.index, {{30, 30}, team});
+    entities.Weapons().Add(entity.index, {TANK_FIRE_COOLDOWN, 0, false, false});
+    entities.Healths().Add(entity.index, {hitPoints});
+    entities.Appearances().Add(entity.index, {EntitySprite::TANK, team == TEAM_PLAYER ? WHITE : RED});
+    return entity;
+}
+
+Entity LevelManager::SpawnEnemy(Vector2 position) {
+    Entity entity = SpawnTank(position, TEAM_ENEMY);
+    entities.PathFollowers().Add(entity.index, {position, false});
+    return entity;
+}
+
+void LevelManager::TeleportEntity(Entity entity, Vector2 position) {
+    if (!entities.IsAlive(entity)) return;
+    Transform* transform = entities.Transforms().Find(entity.index);
+    if (!transform) return;
+
+    transform->position = position;
+    transform->previousPosition = position;
+    if (entity.index == player.index) {
+        RefreshPlayerState();
     }
 }
 
-void LevelManager::UpdateTileAnimations() {
-    for (auto& row : currentLevel) {
-        for (auto& tile : row) {
-            if (tile.animating) {
-                tile.animationTimer -= GetFrameTime();
+void LevelManager::UpdatePathFollowers(float dt) {
+    ComponentArray<PathFollower>& followers = entities.PathFollowers();
+    if (followers.Size() == 0) return;
+    PROFILE_ZONE("UpdatePathFollowers");
 
-                // Create jitter effect on x-axis
-                tile.animationOffset = std::sin(tile.animationTimer * 50.0f) * 3.0f;
+    // One field for all of them, repaired for whatever changed since the
+    // last tick. Each tank then only looks up the cell it arrived in.
+    Vector2 playerPos = GetPlayerPosition();
+    float size = (float)tileSize;
+    if (!flowFieldValid) {
+        RebuildFlowField();
+    } else {
+        flowField.SetTarget((int)std::floor(playerPos.x / size), (int)std::floor(playerPos.y / size));
+        flowField.Update();
+    }
 
-                // End animation and destroy tile
-                if (tile.animationTimer <= 0.0f) {
-                    tile.destroyed = true;
-                    tile.animating = false;
-                    tile.animationOffset = 0.0f;
-                }
+    const unsigned blockingTiles = TileMask(TileType::WALL) | TileMask(TileType::DESTRUCTIBLE) |
+                                   TileMask(TileType::BARREL);
+    Rectangle active = GetActiveBounds();
+    for (size_t i = 0; i < followers.Size(); i++) {
+        uint32_t owner = followers.Owner(i);
+        const Transform* transform = entities.Transforms().Find(owner);
+        Velocity* velocity = entities.Velocities().Find(owner);
+        if (!transform || !velocity || !CheckCollisionPointRec(transform->position, active)) continue;
+
+        PathFollower& follower = followers[i];
+        Vector2 pos = transform->position;
+        if (!follower.hasWaypoint) {
+            // Line up on the cell centre first, the field only links centres
+            follower.waypoint = {(std::floor(pos.x / size) + 0.5f) * size, (std::floor(pos.y / size) + 0.5f) * size};
+            follower.hasWaypoint = true;
+        }
+
+        // Close enough to the waypoint to reach it this tick: head on to
+        // the next cell. Tanks stop on the player's cell or when cut off.
+        float step = velocity->speed * dt;
+        Vector2 delta = {follower.waypoint.x - pos.x, follower.waypoint.y - pos.y};
+        if (std::fabs(delta.x) <= step && std::fabs(delta.y) <= step) {
+            int cellX = (int)std::floor(follower.waypoint.x / size);
+            int cellY = (int)std::floor(follower.waypoint.y / size);
+            switch (flowField.GetFlow(cellX, cellY)) {
+                case FlowDirection::LEFT: follower.waypoint.x -= size; break;
+                case FlowDirection::RIGHT: follower.waypoint.x += size; break;
+                case FlowDirection::UP: follower.waypoint.y -= size; break;
+                case FlowDirection::DOWN: follower.waypoint.y += size; break;
+                case FlowDirection::NONE: break;
             }
+            delta = {follower.waypoint.x - pos.x, follower.waypoint.y - pos.y};
+        }
+
+        // Along one axis at a time, like the player
+        if (std::fabs(delta.x) <= step && std::fabs(delta.y) <= step) {
+            velocity->move = {0, 0};
+        } else if (std::fabs(delta.x) >= std::fabs(delta.y)) {
+            velocity->move = {delta.x > 0 ? 1.0f : -1.0f, 0};
+        } else {
+            velocity->move = {0, delta.y > 0 ? 1.0f : -1.0f};
         }
+
+        // Fire when the player is in front, lined up and in plain sight
+        Weapon* weapon = entities.Weapons().Find(owner);
+        if (!weapon || weapon->timer > 0) continue;
+        Vector2 facing = (velocity->move.x != 0 || velocity->move.y != 0) ? velocity->move : transform->direction;
+        Vector2 toPlayer = {playerPos.x - pos.x, playerPos.y - pos.y};
+        float along = toPlayer.x * facing.x + toPlayer.y * facing.y;
+        float across = std::fabs(toPlayer.x * facing.y - toPlayer.y * facing.x);
+        int hitX = 0;
+        int hitY = 0;
+        weapon->trigger = along > 0 && along <= ENEMY_SIGHT_TILES * size && across < size / 4 &&
+                          !TraceTiles(pos, playerPos, blockingTiles, hitX, hitY);
     }
 }
 
-void LevelManager::Draw() {
-    DrawDebug(false);
+void LevelManager::RebuildFlowField() {
+    PROFILE_ZONE("RebuildFlowField");
+    Rectangle active = GetActiveBounds();
+    int minX = (int)(active.x / tileSize);
+    int minY = (int)(active.y / tileSize);
+    int tilesX = (int)(active.width / tileSize);
+    int tilesY = (int)(active.height / tileSize);
+    flowField.Reset(minX, minY, tilesX, tilesY);
+
+    // Tanks can drive wherever they don't collide with a tile
+    const unsigned blockingTiles = TileMask(TileType::WALL) | TileMask(TileType::DESTRUCTIBLE) |
+                                   TileMask(TileType::BARREL);
+    for (int y = minY; y < minY + tilesY; y++) {
+        for (int x = minX; x < minX + tilesX; x++) {
+            const Tile* tile = TileAt(x, y);
+            flowField.SetPassable(x, y, tile && ((tile->flags & TILE_DESTROYED) || !(blockingTiles & TileMask(tile->type))));
+        }
+    }
+
+    Vector2 playerPos = GetPlayerPosition();
+    flowField.SetTarget((int)std::floor(playerPos.x / tileSize), (int)std::floor(playerPos.y / tileSize));
+    flowField.Rebuild();
+    flowFieldValid = true;
 }
 
-void LevelManager::DrawDebug(bool debugMode) {
-    TextureManager* texManager = TextureManager::GetInstance();
-    
-    for (const auto& row : currentLevel) {
-        for (const auto& tile : row) {
-            if (tile.destroyed) continue;
-            
-            if (debugMode) {
-                // Draw hitboxes instead of sprites
-                Color hitboxColor = RED;
-                switch (tile.type) {
-                    case TileType::WALL:
-                        hitboxColor = GRAY;
-                        break;
-                    case TileType::BARREL:
-                        hitboxColor = RED;
-                        break;
-                    case TileType::DESTRUCTIBLE:
-                        hitboxColor = ORANGE;
-                        break;
-                    case TileType::POWER_UP:
-                        hitboxColor = YELLOW;
-                        break;
-                    case TileType::EXIT_POINT:
-                        hitboxColor = GREEN;
-                        break;
-                    default:
-                        hitboxColor = DARKGRAY;
-                        break;
-                }
-                Rectangle debugRect = tile.rect;
-                debugRect.x += tile.animationOffset; // Apply animation offset
-                DrawRectangleRec(debugRect, hitboxColor);
-                DrawRectangleLinesEx(debugRect, 2.0f, BLACK);
-            } else {
-                // Draw sprites normally
-                const char* textureName = nullptr;
-                switch (tile.type) {
-                    case TileType::WALL:
-                        textureName = "wall";
-                        break;
-                    case TileType::DESTRUCTIBLE:
-                        textureName = "destructible";
-                        break;
-                    case TileType::BARREL:
-                        textureName = "barrel";
-                        break;
-                    case TileType::POWER_UP:
-                        textureName = "powerup";
-                        break;
-                    case TileType::EXIT_POINT:
-                        textureName = "exit";
-                        break;
-                    default:
-                        break;
+void LevelManager::UpdateMovement(float dt) {
+    PROFILE_ZONE("UpdateMovement");
+    ComponentArray<Transform>& transforms = entities.Transforms();
+    for (size_t i = 0; i < transforms.Size(); i++) {
+        transforms[i].previousPosition = transforms[i].position;
+    }
+
+    // Tanks outside the resident chunks have no tiles to collide with, so
+    // they wait until the player comes closer
+    Rectangle active = GetActiveBounds();
+    ComponentArray<Velocity>& velocities = entities.Velocities();
+
+    // Everything a tank can bump into, each body grown by as far as it can
+    // move this tick so the hash still covers it after it moved
+    const ComponentArray<Collider>& colliders = entities.Colliders();
+    bodyHash.Clear();
+    for (size_t i = 0; i < colliders.Size(); i++) {
+        uint32_t owner = colliders.Owner(i);
+        const Transform* transform = transforms.Find(owner);
+        if (!transform) continue;
+        const Velocity* velocity = velocities.Find(owner);
+        float reach = velocity ? velocity->speed * dt : 0.0f;
+        Vector2 size = colliders[i].size;
+        bodyHash.Insert(owner, {transform->position.x - size.x / 2 - reach, transform->position.y - size.y / 2 - reach,
+                                size.x + 2 * reach, size.y + 2 * reach});
+    }
+    bool bodiesCanBlock = bodyHash.GetBodyCount() > 1;
+    if (bodiesCanBlock) {
+        bodyHash.Build();
+    }
+
+    for (size_t i = 0; i < velocities.Size(); i++) {
+        Vector2 move = velocities[i].move;
+        if (move.x == 0 && move.y == 0) continue;
+
+        uint32_t owner = velocities.Owner(i);
+        Transform* transform = transforms.Find(owner);
+        if (!transform || !CheckCollisionPointRec(transform->position, active)) continue;
+
+        // Turn even when blocked
+        transform->direction = move;
+        Vector2 newPos = {
+            transform->position.x + move.x * velocities[i].speed * dt,
+            transform->position.y + move.y * velocities[i].speed * dt
+        };
+        if (CheckCollisionWithObstacles(newPos)) continue;
+        if (bodiesCanBlock && IsBlockedByBody(owner, transform->position, newPos)) continue;
+        transform->position = newPos;
+
+        if (owner == player.index) {
+            RefreshPlayerState();
+            Publish({LevelEventType::PLAYER_MOVED, (int)std::floor(newPos.x / tileSize),
+                     (int)std::floor(newPos.y / tileSize), newPos});
+        }
+    }
+}
+
+bool LevelManager::IsBlockedByBody(uint32_t entity, Vector2 from, Vector2 to) {
+    const Collider* collider = entities.Colliders().Find(entity);
+    if (!collider) return false;
+
+    Vector2 size = collider->size;
+    Rectangle current = {from.x - size.x / 2, from.y - size.y / 2, size.x, size.y};
+    Rectangle next = {to.x - size.x / 2, to.y - size.y / 2, size.x, size.y};
+    bool blocked = false;
+    bodyHash.Query(next, [&](uint32_t other) {
+        if (blocked || other == entity) return;
+        Vector2 position = entities.Transforms().Find(other)->position;
+        Vector2 otherSize = entities.Colliders().Find(other)->size;
+        Rectangle rect = {position.x - otherSize.x / 2, position.y - otherSize.y / 2, otherSize.x, otherSize.y};
+        // Tanks that already overlap, spawned on top of each other, may
+        // still drive apart
+        blocked = CheckCollisionRecs(next, rect) && !CheckCollisionRecs(current, rect);
+    });
+    return blocked;
+}
+
+void LevelManager::UpdateWeapons(float dt) {
+    PROFILE_ZONE("UpdateWeapons");
+    Rectangle active = GetActiveBounds();
+    ComponentArray<Weapon>& weapons = entities.Weapons();
+    for (size_t i = 0; i < weapons.Size(); i++) {
+        Weapon& weapon = weapons[i];
+        if (weapon.trigger && weapon.timer <= 0) {
+            uint32_t owner = weapons.Owner(i);
+            const Transform* transform = entities.Transforms().Find(owner);
+            const Collider* collider = entities.Colliders().Find(owner);
+            // A full pool just swallows the shot, nothing is allocated mid-game
+            if (transform && CheckCollisionPointRec(transform->position, active)) {
+                bullets.Spawn(transform->position, transform->direction, weapon.powerUp,
+                              entities.GetEntity(owner), collider ? collider->team : TEAM_NEUTRAL);
+            }
+            weapon.timer = weapon.cooldown;
+        }
+        weapon.trigger = false;
+        if (weapon.timer > 0) {
+            weapon.timer -= dt;
+        }
+    }
+}
+
+void LevelManager::CheckBulletHits() {
+    PROFILE_ZONE("CheckBulletHits");
+    if (bullets.Size() == 0) return;
+
+    // Everything with health under the resident chunks, collected once
+    hitTargets.clear();
+    size_t teamTargets[TEAM_COUNT] = {};
+    Rectangle active = GetActiveBounds();
+    ComponentArray<Health>& healths = entities.Healths();
+    for (size_t i = 0; i < healths.Size(); i++) {
+        uint32_t owner = healths.Owner(i);
+        const Transform* transform = entities.Transforms().Find(owner);
+        const Collider* collider = entities.Colliders().Find(owner);
+        if (!transform || !collider || !CheckCollisionPointRec(transform->position, active)) continue;
+
+        Rectangle rect = {transform->position.x - collider->size.x / 2, transform->position.y - collider->size.y / 2,
+                          collider->size.x, collider->size.y};
+        hitTargets.push_back({rect, collider->team, owner});
+        if (collider->team < TEAM_COUNT) teamTargets[collider->team]++;
+    }
+    if (hitTargets.empty()) return;
+
+    // A few targets are quicker to scan than to hash
+    bool hashed = hitTargets.size() > HIT_SCAN_TARGETS;
+    if (hashed) {
+        bodyHash.Clear();
+        for (size_t t = 0; t < hitTargets.size(); t++) {
+            bodyHash.Insert((uint32_t)t, hitTargets[t].rect);
+        }
+        bodyHash.Build();
+    }
+
+    for (size_t i = 0; i < bullets.Size(); i++) {
+        if (bullets.ShouldDestroy(i)) continue;
+        uint8_t team = bullets.GetTeam(i);
+        // Every target is on the bullet's own team
+        if (team < TEAM_COUNT && teamTargets[team] == hitTargets.size()) continue;
+
+        // The first target in collection order takes the hit, as if they
+        // had all been tested one after the other
+        Rectangle hitbox = bullets.GetHitbox(i);
+        uint32_t hit = UINT32_MAX;
+        if (hashed) {
+            bodyHash.Query(hitbox, [&](uint32_t target) {
+                if (target < hit && hitTargets[target].team != team && CheckCollisionRecs(hitbox, hitTargets[target].rect)) {
+                    hit = target;
                 }
-                
-                if (textureName) {
-                    Texture2D texture = texManager->GetTexture(textureName);
-                Rectangle drawRect = tile.rect;
-                drawRect.x += tile.animationOffset; // Apply animation offset
-
-                DrawTexturePro(texture,
-                    {0, 0, (float)texture.width, (float)texture.height},
-                    drawRect,
-                    {0, 0}, 0, WHITE);
+            });
+        } else {
+            for (size_t t = 0; t < hitTargets.size(); t++) {
+                if (hitTargets[t].team != team && CheckCollisionRecs(hitbox, hitTargets[t].rect)) {
+                    hit = (uint32_t)t;
+                    break;
                 }
             }
         }
+        if (hit != UINT32_MAX) {
+            healths.Find(hitTargets[hit].entity)->hitPoints--;
+            bullets.MarkForDestruction(i);
+        }
     }
 }
 
-Player& LevelManager::GetPlayer() {
-    return player;
-}
+void LevelManager::UpdateExplosions() {
+    PROFILE_ZONE("UpdateExplosions");
 
-bool LevelManager::AreAllDestructiblesDestroyed() {
-    for (const auto& row : currentLevel) {
-        for (const auto& tile : row) {
-            if (tile.type == TileType::DESTRUCTIBLE && !tile.destroyed) {
-                return false;
+    // Breadth first: blasts go off in the order they were queued, the
+    // barrels they catch queue theirs when they finish animating
+    size_t end = std::min(detonations.size(), detonationHead + MAX_DETONATIONS_PER_TICK);
+    for (; detonationHead < end; detonationHead++) {
+        Detonation blast = detonations[detonationHead];
+        int centerX = blast.index % width;
+        int centerY = blast.index / width;
+        for (int y = std::max(0, centerY - blast.radius); y <= std::min(height - 1, centerY + blast.radius); y++) {
+            for (int x = std::max(0, centerX - blast.radius); x <= std::min(width - 1, centerX + blast.radius); x++) {
+                const Tile* tile = TileAt(x, y);
+                if (tile && (tile->type == TileType::DESTRUCTIBLE || tile->type == TileType::BARREL)) {
+                    // Ignores tiles that are already going
+                    StartTileAnimation(x, y);
+                }
             }
         }
     }
-    return true;
+
+    // Drop what went off once it is most of the buffer
+    if (detonationHead == detonations.size()) {
+        detonations.clear();
+        detonationHead = 0;
+    } else if (detonationHead > detonations.size() / 2) {
+        detonations.erase(detonations.begin(), detonations.begin() + detonationHead);
+        detonationHead = 0;
+    }
 }
 
-bool LevelManager::IsPlayerDead() {
-    return CheckCollisionWithBarrel(player.GetPosition());
+void LevelManager::RemoveDeadEntities() {
+    ComponentArray<Health>& healths = entities.Healths();
+    for (size_t i = 0; i < healths.Size();) {
+        uint32_t owner = healths.Owner(i);
+        if (healths[i].hitPoints > 0 || owner == player.index) {
+            i++;
+            continue;
+        }
+
+        const Transform* transform = entities.Transforms().Find(owner);
+        Vector2 pos = transform ? transform->position : Vector2{0, 0};
+        Publish({LevelEventType::ENTITY_DESTROYED, (int)std::floor(pos.x / tileSize),
+                 (int)std::floor(pos.y / tileSize), pos});
+        // Swaps the last health into i, so look at i again
+        entities.Destroy(entities.GetEntity(owner));
+    }
+
+    // The player stays around for the game over screen
+    if (healths.Find(player.index)->hitPoints <= 0) {
+        playerDead = true;
+    }
 }
 
-bool LevelManager::IsPlayerOnExit() {
-    Vector2 playerPos = player.GetPosition();
-    Rectangle playerRect = {playerPos.x - 15, playerPos.y - 15, 30, 30};
+void LevelManager::RefreshPlayerState() {
+    Vector2 pos = GetPlayerPosition();
+    playerDead = CheckCollisionWithBarrel(pos) || entities.Healths().Find(player.index)->hitPoints <= 0;
 
     // Check if player rectangle overlaps with exit point area
+    Rectangle playerRect = {pos.x - 15, pos.y - 15, 30, 30};
     Rectangle exitRect = {exitPoint.x - 20, exitPoint.y - 20, 40, 40};
-    return CheckCollisionRecs(playerRect, exitRect);
+    playerOnExit = CheckCollisionRecs(playerRect, exitRect);
 }
 
-void LevelManager::CheckBulletCollisions() {
-    auto& bullets = player.GetBullets();
-    
-    for (auto& bullet : bullets) {
-        Rectangle bulletHitbox = bullet.GetHitbox();
-        
-        for (int y = 0; y < currentLevel.size(); y++) {
-            for (int x = 0; x < currentLevel[y].size(); x++) {
-                auto& tile = currentLevel[y][x];
-                
-                if (tile.destroyed) continue;
-                
-                // Use rectangle-rectangle collision for more accurate hitbox detection
-                if (CheckCollisionRecs(bulletHitbox, tile.rect)) {
-                    if (tile.type == TileType::DESTRUCTIBLE ||
-                        tile.type == TileType::BARREL ||
-                        tile.type == TileType::POWER_UP) {
-
-                        if (tile.type == TileType::POWER_UP) {
-                            player.GivePowerUp();
-                        }
-
-                        // If bullet has power up, destroy adjacent tiles
-                        if (bullet.HasPowerUp()) {
-                            for (int dy = -1; dy <= 1; dy++) {
-                                for (int dx = -1; dx <= 1; dx++) {
-                                    int nx = x + dx;
-                                    int ny = y + dy;
-                                    if (nx >= 0 && nx < currentLevel[y].size() &&
-                                        ny >= 0 && ny < currentLevel.size()) {
-                                        auto& adjacentTile = currentLevel[ny][nx];
-                                        if (adjacentTile.type == TileType::DESTRUCTIBLE ||
-                                            adjacentTile.type == TileType::BARREL) {
-                                            // Start animation for adjacent tiles too
-                                            if (!adjacentTile.animating && !adjacentTile.destroyed) {
-                                                adjacentTile.animating = true;
-                                                adjacentTile.animationTimer = 0.3f; // 0.3 seconds animation
-                                            }
-                                        }
-                                    }
-                                }
-                            }
-                        }
-
-                        // Start destruction animation instead of immediate destruction
-                        if (!tile.animating && !tile.destroyed) {
-                            tile.animating = true;
-                            tile.animationTimer = 0.3f; // 0.3 seconds animation
-                        }
-
-                        bullet.MarkForDestruction();
-                        break;
-                    } else if (tile.type == TileType::WALL) {
-                        bullet.MarkForDestruction();
-                        break;
-                    }
+void LevelManager::Publish(const LevelEvent& event) {
+    for (auto& listener : listeners) {
+        listener(event);
+    }
+}
+
+void LevelManager::AddListener(LevelEventListener listener) {
+    listeners.push_back(std::move(listener));
+}
+
+void LevelManager::UpdateStatus() {
+    // Dying beats winning, winning beats running out of time
+    if (playerDead) {
+        status = LevelStatus::LOST;
+    } else if (remainingDestructibles == 0 || playerOnExit) {
+        status = LevelStatus::WON;
+    } else if (elapsedTime >= timeLimit) {
+        status = LevelStatus::LOST;
+    }
+}
+
+void LevelManager::UpdateTileAnimations(float dt) {
+    PROFILE_ZONE("UpdateTileAnimations");
+    for (size_t i = 0; i < activeAnimations.size();) {
+        TileAnimation& anim = activeAnimations[i];
+        anim.timer -= dt;
+
+        // Create jitter effect on x-axis
+        anim.offset = std::sin(anim.timer * 50.0f) * 3.0f;
+
+        // End animation and destroy tile
+        if (anim.timer <= 0.0f) {
+            int index = anim.index;
+            // Swap with the last entry and pop, order doesn't matter
+            activeAnimations[i] = activeAnimations.back();
+            activeAnimations.pop_back();
+            DestroyTile(index);
+        } else {
+            i++;
+        }
+    }
+}
+
+void LevelManager::StartTileAnimation(int x, int y) {
+    Tile* tile = TileAt(x, y);
+    if (!tile || (tile->flags & (TILE_ANIMATING | TILE_DESTROYED))) return;
+
+    tile->flags |= TILE_ANIMATING;
+    activeAnimations.push_back({y * width + x, TILE_ANIMATION_TIME, 0.0f});
+    slotModified[chunkSlots[(y >> CHUNK_SHIFT) * chunksX + (x >> CHUNK_SHIFT)]] = true;
+
+    // It moves to the animated pass, take it out of the cached layer
+    if (FindChunkLayer((y >> CHUNK_SHIFT) * chunksX + (x >> CHUNK_SHIFT)) >= 0) {
+        dirtyTiles.push_back(y * width + x);
+    }
+
+    Publish({LevelEventType::TILE_EXPLODING, x, y, GetPlayerPosition()});
+}
+
+void LevelManager::DestroyTile(int index) {
+    Tile& tile = *TileAt(index % width, index / width);
+    tile.flags = (tile.flags & ~TILE_ANIMATING) | TILE_DESTROYED;
+    if (flowFieldValid) {
+        flowField.SetPassable(index % width, index / width, true);
+    }
+
+    if (tile.type == TileType::DESTRUCTIBLE) {
+        remainingDestructibles--;
+    } else if (tile.type == TileType::BARREL) {
+        QueueDetonation(index % width, index / width, barrelBlastRadius);
+        if (playerDead) {
+            RefreshPlayerState();
+        }
+    }
+
+    Publish({LevelEventType::TILE_DESTROYED, index % width, index / width, GetPlayerPosition()});
+}
+
+void LevelManager::QueueDetonation(int x, int y, int radius) {
+    detonations.push_back({y * width + x, radius});
+}
+
+void LevelManager::SetRemoteView(bool remote) {
+    remoteView = remote;
+}
+
+bool LevelManager::IsRemoteView() const {
+    return remoteView;
+}
+
+void LevelManager::SetRemoteTile(int x, int y, uint8_t flags) {
+    if (x < 0 || x >= width || y < 0 || y >= height) return;
+    int chunk = (y >> CHUNK_SHIFT) * chunksX + (x >> CHUNK_SHIFT);
+    int index = y * width + x;
+
+    Tile* tile = TileAt(x, y);
+    if (!tile) {
+        // Parked the way EvictChunk does it, LoadChunk picks it up
+        std::vector<Tile>& parked = modifiedChunks[chunk];
+        if (parked.empty()) {
+            parked.resize(CHUNK_TILES);
+            CopySourceChunk(chunk, parked.data());
+        }
+        parked[((y & (CHUNK_SIZE - 1)) << CHUNK_SHIFT) + (x & (CHUNK_SIZE - 1))].flags = flags;
+        return;
+    }
+    if (tile->flags == flags) return;
+
+    bool wasAnimating = (tile->flags & TILE_ANIMATING) != 0;
+    tile->flags = flags;
+    slotModified[chunkSlots[chunk]] = true;
+    if ((flags & TILE_ANIMATING) && !wasAnimating) {
+        activeAnimations.push_back({index, TILE_ANIMATION_TIME, 0.0f});
+    } else if (!(flags & TILE_ANIMATING) && wasAnimating) {
+        for (size_t i = 0; i < activeAnimations.size(); i++) {
+            if (activeAnimations[i].index == index) {
+                activeAnimations[i] = activeAnimations.back();
+                activeAnimations.pop_back();
+                break;
+            }
+        }
+    }
+    if (FindChunkLayer(chunk) >= 0) {
+        dirtyTiles.push_back(index);
+    }
+}
+
+void LevelManager::UpdateRemoteView(float dt) {
+    UpdateStreaming();
+
+    // The server says when a tile is gone, until then it keeps shaking
+    for (TileAnimation& anim : activeAnimations) {
+        anim.timer -= dt;
+        anim.offset = std::sin(anim.timer * 50.0f) * 3.0f;
+    }
+}
+
+int LevelManager::FindChunkLayer(int chunk) const {
+    for (int i = 0; i < MAX_CHUNK_LAYERS; i++) {
+        if (chunkLayers[i].chunk == chunk) return i;
+    }
+    return -1;
+}
+
+Tile* LevelManager::TileAt(int x, int y) {
+    if (x < 0 || x >= width || y < 0 || y >= height) return nullptr;
+
+    int slot = chunkSlots[(y >> CHUNK_SHIFT) * chunksX + (x >> CHUNK_SHIFT)];
+    if (slot < 0) return nullptr;
+    return &chunkPool[(size_t)slot * CHUNK_TILES + ((y & (CHUNK_SIZE - 1)) << CHUNK_SHIFT) +
+                      (x & (CHUNK_SIZE - 1))];
+}
+
+const Tile* LevelManager::GetTile(int x, int y) const {
+    return const_cast<LevelManager*>(this)->TileAt(x, y);
+}
+
+void LevelManager::UpdateStreaming() {
+    Vector2 pos = GetPlayerPosition();
+    int centerX = std::clamp((int)std::floor(pos.x / tileSize) >> CHUNK_SHIFT, 0, chunksX - 1);
+    int centerY = std::clamp((int)std::floor(pos.y / tileSize) >> CHUNK_SHIFT, 0, chunksY - 1);
+    int center = centerY * chunksX + centerX;
+    if (center == streamCenter) return;
+    streamCenter = center;
+    flowFieldValid = false;
+
+    // Drop what fell out of the window first so its slots can be reused
+    for (int slot = 0; slot < MAX_RESIDENT_CHUNKS; slot++) {
+        int chunk = slotChunks[slot];
+        if (chunk < 0) continue;
+        if (std::abs(chunk % chunksX - centerX) > STREAM_RADIUS ||
+            std::abs(chunk / chunksX - centerY) > STREAM_RADIUS) {
+            EvictChunk(chunk);
+        }
+    }
+
+    for (int cy = std::max(0, centerY - STREAM_RADIUS); cy <= std::min(chunksY - 1, centerY + STREAM_RADIUS); cy++) {
+        for (int cx = std::max(0, centerX - STREAM_RADIUS); cx <= std::min(chunksX - 1, centerX + STREAM_RADIUS); cx++) {
+            if (chunkSlots[cy * chunksX + cx] < 0) {
+                LoadChunk(cy * chunksX + cx);
+            }
+        }
+    }
+}
+
+void LevelManager::LoadChunk(int chunk) {
+    int slot = (int)(std::find(slotChunks.begin(), slotChunks.end(), -1) - slotChunks.begin());
+    Tile* dest = &chunkPool[(size_t)slot * CHUNK_TILES];
+
+    auto parked = modifiedChunks.find(chunk);
+    if (parked != modifiedChunks.end()) {
+        std::copy(parked->second.begin(), parked->second.end(), dest);
+        modifiedChunks.erase(parked);
+        slotModified[slot] = true;
+    } else {
+        CopySourceChunk(chunk, dest);
+        slotModified[slot] = false;
+    }
+
+    slotChunks[slot] = chunk;
+    chunkSlots[chunk] = slot;
+    // A server sends its enemies along with everything else
+    if (!remoteView) {
+        SpawnChunkEnemies(chunk);
+    }
+}
+
+void LevelManager::SpawnChunkEnemies(int chunk) {
+    // Markers are used up as they spawn, so a chunk that comes back out of
+    // modifiedChunks doesn't spawn its tanks a second time
+    int slot = chunkSlots[chunk];
+    Tile* tilesInSlot = &chunkPool[(size_t)slot * CHUNK_TILES];
+    int firstX = (chunk % chunksX) * CHUNK_SIZE;
+    int firstY = (chunk / chunksX) * CHUNK_SIZE;
+
+    // Markers are rare and chunks load on every step across a chunk
+    // border, so let memchr find the type byte instead of a tile loop
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(tilesInSlot);
+    const unsigned char* end = bytes + CHUNK_TILES * sizeof(Tile);
+    const unsigned char* found = bytes;
+    while ((found = static_cast<const unsigned char*>(
+                std::memchr(found, (int)TileType::ENEMY_SPAWN, end - found))) != nullptr) {
+        int i = (int)((found - bytes) / sizeof(Tile));
+        found++;
+        Tile& tile = tilesInSlot[i];
+        // The match may have been a flags byte
+        if (tile.type != TileType::ENEMY_SPAWN || (tile.flags & TILE_DESTROYED)) continue;
+
+        tile.flags |= TILE_DESTROYED;
+        slotModified[slot] = true;
+        Rectangle rect = GetTileRect(firstX + (i & (CHUNK_SIZE - 1)), firstY + (i >> CHUNK_SHIFT));
+        SpawnEnemy({rect.x + tileSize/2, rect.y + tileSize/2});
+    }
+}
+
+void LevelManager::CopySourceChunk(int chunk, Tile* dest) const {
+    // Straight row copies out of the source, cells past the level edge
+    // stay empty and are never looked at
+    int firstX = (chunk % chunksX) * CHUNK_SIZE;
+    int firstY = (chunk / chunksX) * CHUNK_SIZE;
+    int tilesX = std::min(CHUNK_SIZE, width - firstX);
+    int tilesY = std::min(CHUNK_SIZE, height - firstY);
+    std::fill(dest, dest + CHUNK_TILES, Tile{TileType::EMPTY, 0});
+    for (int y = 0; y < tilesY; y++) {
+        const Tile* row = sourceTiles + (size_t)(firstY + y) * width + firstX;
+        std::copy(row, row + tilesX, dest + y * CHUNK_SIZE);
+    }
+
+    // Bad type bytes in the file would index past the sprite table and the
+    // TileMask bits, they come into play as empty cells. Flags are play
+    // state, a file has none. Four tiles are checked at a time: each type
+    // is the low byte of its little-endian pair, the flags the high byte,
+    // and only types from 8 up have a bit in 0xf8.
+    static_assert(TILE_TYPE_COUNT == 8 && CHUNK_TILES % 4 == 0, "the tile check assumes 3-bit types");
+    uint64_t bits = 0;
+    for (int i = 0; i < CHUNK_TILES; i += 4) {
+        uint64_t word;
+        std::memcpy(&word, dest + i, sizeof(word));
+        bits |= word;
+    }
+    if (bits & 0xfff8fff8fff8fff8ull) {
+        for (int i = 0; i < CHUNK_TILES; i++) {
+            if ((uint8_t)dest[i].type >= TILE_TYPE_COUNT) {
+                dest[i] = Tile{TileType::EMPTY, 0};
+            }
+            dest[i].flags = 0;
+        }
+    }
+}
+
+void LevelManager::InvalidateChunkLayer(int chunk) {
+    int found = FindChunkLayer(chunk);
+    if (found >= 0) {
+        chunkLayers[found].chunk = -1;
+    }
+}
+
+void LevelManager::EvictChunk(int chunk) {
+    int slot = chunkSlots[chunk];
+
+    // Anything still exploding in there finishes now
+    for (size_t i = 0; i < activeAnimations.size();) {
+        int index = activeAnimations[i].index;
+        int x = index % width;
+        int y = index / width;
+        if ((y >> CHUNK_SHIFT) * chunksX + (x >> CHUNK_SHIFT) == chunk) {
+            activeAnimations[i] = activeAnimations.back();
+            activeAnimations.pop_back();
+            // In remote view the server destroys it and says so
+            if (!remoteView) {
+                DestroyTile(index);
+            }
+        } else {
+            i++;
+        }
+    }
+
+    if (slotModified[slot]) {
+        const Tile* tilesInSlot = &chunkPool[(size_t)slot * CHUNK_TILES];
+        modifiedChunks[chunk].assign(tilesInSlot, tilesInSlot + CHUNK_TILES);
+    }
+
+    InvalidateChunkLayer(chunk);
+
+    slotChunks[slot] = -1;
+    chunkSlots[chunk] = -1;
+}
+
+void LevelManager::SetBulletCapacity(size_t capacity) {
+    bulletCapacity = capacity;
+}
+
+void LevelManager::SetBlastRadius(int barrelRadius, int powerUpRadius) {
+    barrelBlastRadius = std::clamp(barrelRadius, 0, MAX_BLAST_RADIUS);
+    powerUpBlastRadius = std::clamp(powerUpRadius, 0, MAX_BLAST_RADIUS);
+}
+
+size_t LevelManager::GetPendingDetonations() const {
+    return detonations.size() - detonationHead;
+}
+
+Entity LevelManager::GetPlayer() const {
+    return player;
+}
+
+Vector2 LevelManager::GetPlayerPosition(float alpha) const {
+    return GetEntityPosition(player, alpha);
+}
+
+Vector2 LevelManager::GetEntityPosition(Entity entity, float alpha) const {
+    if (!entities.IsAlive(entity)) return Vector2{0, 0};
+    const Transform* transform = entities.Transforms().Find(entity.index);
+    if (!transform) return Vector2{0, 0};
+    return {
+        transform->previousPosition.x + (transform->position.x - transform->previousPosition.x) * alpha,
+        transform->previousPosition.y + (transform->position.y - transform->previousPosition.y) * alpha
+    };
+}
+
+EntityStore& LevelManager::GetEntities() {
+    return entities;
+}
+
+const EntityStore& LevelManager::GetEntities() const {
+    return entities;
+}
+
+BulletPool& LevelManager::GetBullets() {
+    return bullets;
+}
+
+const BulletPool& LevelManager::GetBullets() const {
+    return bullets;
+}
+
+const FlowField& LevelManager::GetFlowField() const {
+    return flowField;
+}
+
+LevelStatus LevelManager::GetStatus() const {
+    return status;
+}
+
+float LevelManager::GetTimeRemaining() const {
+    return timeLimit - elapsedTime;
+}
+
+int LevelManager::GetWidth() const {
+    return width;
+}
+
+int LevelManager::GetHeight() const {
+    return height;
+}
+
+int LevelManager::GetTileSize() const {
+    return tileSize;
+}
+
+Rectangle LevelManager::GetTileRect(int x, int y) const {
+    return {x * tileSize * 1.0f, y * tileSize * 1.0f, tileSize * 1.0f, tileSize * 1.0f};
+}
+
+Rectangle LevelManager::GetWorldBounds() const {
+    return {0, 0, width * tileSize * 1.0f, height * tileSize * 1.0f};
+}
+
+Rectangle LevelManager::GetActiveBounds() const {
+    if (streamCenter < 0) return Rectangle{0, 0, 0, 0};
+
+    int centerX = streamCenter % chunksX;
+    int centerY = streamCenter / chunksX;
+    int minX = std::max(0, centerX - STREAM_RADIUS) * CHUNK_SIZE;
+    int minY = std::max(0, centerY - STREAM_RADIUS) * CHUNK_SIZE;
+    int maxX = std::min(width, (centerX + STREAM_RADIUS + 1) * CHUNK_SIZE);
+    int maxY = std::min(height, (centerY + STREAM_RADIUS + 1) * CHUNK_SIZE);
+    return {minX * tileSize * 1.0f, minY * tileSize * 1.0f,
+            (maxX - minX) * tileSize * 1.0f, (maxY - minY) * tileSize * 1.0f};
+}
+
+int LevelManager::GetResidentChunkCount() const {
+    return (int)std::count_if(slotChunks.begin(), slotChunks.end(), [](int chunk) { return chunk >= 0; });
+}
+
+bool LevelManager::AreAllDestructiblesDestroyed() const {
+    return remainingDestructibles == 0;
+}
+
+int LevelManager::GetRemainingDestructibles() const {
+    return remainingDestructibles;
+}
+
+bool LevelManager::IsPlayerDead() const {
+    return playerDead;
+}
+
+bool LevelManager::IsPlayerOnExit() const {
+    return playerOnExit;
+}
+
+// FNV-1a, floats are hashed by their bits
+static uint64_t HashBytes(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+template <typename T>
+static uint64_t HashValue(uint64_t hash, const T& value) {
+    return HashBytes(hash, &value, sizeof(T));
+}
+
+uint64_t LevelManager::GetStateHash() const {
+    uint64_t hash = 14695981039346656037ull;
+    hash = HashValue(hash, width);
+    hash = HashValue(hash, height);
+    hash = HashValue(hash, elapsedTime);
+    hash = HashValue(hash, status);
+    hash = HashValue(hash, remainingDestructibles);
+
+    // Entities in component order, which only depends on what happened
+    const ComponentArray<Transform>& transforms = entities.Transforms();
+    for (size_t i = 0; i < transforms.Size(); i++) {
+        uint32_t owner = transforms.Owner(i);
+        hash = HashValue(hash, owner);
+        hash = HashValue(hash, transforms[i].position);
+        hash = HashValue(hash, transforms[i].direction);
+        const Velocity* velocity = entities.Velocities().Find(owner);
+        if (velocity) {
+            hash = HashValue(hash, velocity->move);
+        }
+        const Weapon* weapon = entities.Weapons().Find(owner);
+        if (weapon) {
+            hash = HashValue(hash, weapon->timer);
+            hash = HashValue(hash, weapon->powerUp);
+        }
+        const Health* health = entities.Healths().Find(owner);
+        if (health) {
+            hash = HashValue(hash, health->hitPoints);
+        }
+        const PathFollower* follower = entities.PathFollowers().Find(owner);
+        if (follower) {
+            hash = HashValue(hash, follower->waypoint);
+            hash = HashValue(hash, follower->hasWaypoint);
+        }
+    }
+
+    hash = HashValue(hash, bullets.Size());
+    for (size_t i = 0; i < bullets.Size(); i++) {
+        hash = HashValue(hash, bullets.GetPosition(i));
+        hash = HashValue(hash, bullets.GetVelocity(i));
+        hash = HashValue(hash, bullets.HasPowerUp(i));
+    }
+
+    // Animations are kept unordered, so sum them up instead of chaining
+    uint64_t animations = 0;
+    for (const TileAnimation& anim : activeAnimations) {
+        animations += HashValue(HashValue(14695981039346656037ull, anim.index), anim.timer);
+    }
+    hash = HashValue(hash, animations);
+
+    hash = HashValue(hash, detonations.size() - detonationHead);
+    for (size_t i = detonationHead; i < detonations.size(); i++) {
+        hash = HashValue(hash, detonations[i]);
+    }
+
+    // Every chunk that differs from the level file, in chunk order
+    for (int chunk = 0; chunk < chunksX * chunksY; chunk++) {
+        int slot = chunkSlots[chunk];
+        if (slot >= 0 && slotModified[slot]) {
+            hash = HashValue(hash, chunk);
+            hash = HashBytes(hash, &chunkPool[(size_t)slot * CHUNK_TILES], CHUNK_TILES * sizeof(Tile));
+            continue;
+        }
+        auto parked = modifiedChunks.find(chunk);
+        if (parked != modifiedChunks.end()) {
+            hash = HashValue(hash, chunk);
+            hash = HashBytes(hash, parked->second.data(), CHUNK_TILES * sizeof(Tile));
+        }
+    }
+    return hash;
+}
+
+// Fixed part of a snapshot. The entities, the bullets, the animations, the pending
+// detonations, the tiles of each modified resident chunk (in slot order) and the
+// parked chunks follow.
+struct LevelSnapshotHeader {
+    int width;
+    int height;
+    float elapsedTime;
+    LevelStatus status;
+    int remainingDestructibles;
+    bool playerDead;
+    bool playerOnExit;
+    int streamCenter;
+    uint32_t animationCount;
+    uint32_t detonationCount;
+    uint32_t parkedCount;
+    int slotChunks[MAX_RESIDENT_CHUNKS];
+    bool slotModified[MAX_RESIDENT_CHUNKS];
+};
+
+void LevelManager::SaveSnapshot(Snapshot& snapshot) const {
+    LevelSnapshotHeader header = {};
+    header.width = width;
+    header.height = height;
+    header.elapsedTime = elapsedTime;
+    header.status = status;
+    header.remainingDestructibles = remainingDestructibles;
+    header.playerDead = playerDead;
+    header.playerOnExit = playerOnExit;
+    header.streamCenter = streamCenter;
+    header.animationCount = (uint32_t)activeAnimations.size();
+    header.detonationCount = (uint32_t)(detonations.size() - detonationHead);
+    header.parkedCount = (uint32_t)modifiedChunks.size();
+    for (int slot = 0; slot < MAX_RESIDENT_CHUNKS; slot++) {
+        header.slotChunks[slot] = slotChunks[slot];
+        header.slotModified[slot] = slotModified[slot];
+    }
+
+    snapshot.Clear();
+    snapshot.WriteValue(header);
+    entities.SaveState(snapshot);
+    snapshot.WriteValue(player);
+    bullets.SaveState(snapshot);
+    snapshot.Write(activeAnimations.data(), activeAnimations.size() * sizeof(TileAnimation));
+    snapshot.Write(detonations.data() + detonationHead, header.detonationCount * sizeof(Detonation));
+
+    for (int slot = 0; slot < MAX_RESIDENT_CHUNKS; slot++) {
+        if (slotChunks[slot] >= 0 && slotModified[slot]) {
+            snapshot.Write(&chunkPool[(size_t)slot * CHUNK_TILES], CHUNK_TILES * sizeof(Tile));
+        }
+    }
+    for (const auto& parked : modifiedChunks) {
+        snapshot.WriteValue(parked.first);
+        snapshot.Write(parked.second.data(), CHUNK_TILES * sizeof(Tile));
+    }
+}
+
+// Skips one chunk of snapshot tiles, false if it runs out or a tile type
+// is out of range (types index the sprite table and TileMask)
+static bool SkipChunkTiles(const Snapshot& snapshot, size_t& offset) {
+    size_t start = offset;
+    if (!snapshot.Skip(offset, CHUNK_TILES * sizeof(Tile))) return false;
+    for (int i = 0; i < CHUNK_TILES; i++) {
+        Tile tile;
+        std::memcpy(&tile, snapshot.Data() + start + i * sizeof(Tile), sizeof(Tile));
+        if ((uint8_t)tile.type >= TILE_TYPE_COUNT) return false;
+    }
+    return true;
+}
+
+bool LevelManager::RestoreSnapshot(const Snapshot& snapshot) {
+    size_t offset = 0;
+    LevelSnapshotHeader header;
+    if (!snapshot.ReadValue(offset, header) || header.width != width || header.height != height) {
+        return false;
+    }
+
+    // Walk the whole snapshot before changing anything, so a truncated or
+    // corrupt one, or one from a pool of another capacity, leaves the
+    // level as it was
+    int chunkCount = chunksX * chunksY;
+    size_t modifiedSlots = 0;
+    for (int slot = 0; slot < MAX_RESIDENT_CHUNKS; slot++) {
+        int chunk = header.slotChunks[slot];
+        if (chunk < -1 || chunk >= chunkCount ||
+            (chunk >= 0 && std::find(header.slotChunks, header.slotChunks + slot, chunk) != header.slotChunks + slot)) {
+            return false;
+        }
+        if (chunk >= 0 && header.slotModified[slot]) modifiedSlots++;
+    }
+    // The entities go into a spare store, the player has to be a whole tank
+    // in it, Update and RefreshPlayerState take that for granted
+    size_t check = offset;
+    Entity restoredPlayer = INVALID_ENTITY;
+    if (!restoreEntities.RestoreState(snapshot, check) || !snapshot.ReadValue(check, restoredPlayer) ||
+        !restoreEntities.IsAlive(restoredPlayer) || !restoreEntities.Transforms().Find(restoredPlayer.index) ||
+        !restoreEntities.Velocities().Find(restoredPlayer.index) ||
+        !restoreEntities.Colliders().Find(restoredPlayer.index) ||
+        !restoreEntities.Weapons().Find(restoredPlayer.index) ||
+        !restoreEntities.Healths().Find(restoredPlayer.index)) {
+        return false;
+    }
+    size_t bulletsAt = check;
+    if (!bullets.SkipState(snapshot, check)) return false;
+
+    // Animating tiles are looked up in the resident chunks, blasts anywhere
+    // on the level
+    for (uint32_t i = 0; i < header.animationCount; i++) {
+        TileAnimation anim;
+        if (!snapshot.ReadValue(check, anim) || anim.index < 0 || anim.index >= width * height) return false;
+        int chunk = ((anim.index / width) >> CHUNK_SHIFT) * chunksX + ((anim.index % width) >> CHUNK_SHIFT);
+        if (std::find(header.slotChunks, header.slotChunks + MAX_RESIDENT_CHUNKS, chunk) ==
+            header.slotChunks + MAX_RESIDENT_CHUNKS) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header.detonationCount; i++) {
+        Detonation blast;
+        if (!snapshot.ReadValue(check, blast) || blast.index < 0 || blast.index >= width * height ||
+            blast.radius < 0 || blast.radius > MAX_BLAST_RADIUS) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < modifiedSlots; i++) {
+        if (!SkipChunkTiles(snapshot, check)) return false;
+    }
+    for (uint32_t i = 0; i < header.parkedCount; i++) {
+        int chunk = 0;
+        if (!snapshot.ReadValue(check, chunk) || chunk < 0 || chunk >= chunkCount ||
+            std::find(header.slotChunks, header.slotChunks + MAX_RESIDENT_CHUNKS, chunk) !=
+                header.slotChunks + MAX_RESIDENT_CHUNKS ||
+            !SkipChunkTiles(snapshot, check)) {
+            return false;
+        }
+    }
+    if (check != snapshot.Size()) return false;
+
+    // Nothing below can run out of snapshot
+    elapsedTime = header.elapsedTime;
+    status = header.status;
+    remainingDestructibles = header.remainingDestructibles;
+    playerDead = header.playerDead;
+    playerOnExit = header.playerOnExit;
+    streamCenter = header.streamCenter;
+    flowFieldValid = false;
+    std::swap(entities, restoreEntities);
+    player = restoredPlayer;
+    offset = bulletsAt;
+    bullets.RestoreState(snapshot, offset);
+    activeAnimations.resize(header.animationCount);
+    snapshot.Read(offset, activeAnimations.data(), activeAnimations.size() * sizeof(TileAnimation));
+    detonations.resize(header.detonationCount);
+    detonationHead = 0;
+    snapshot.Read(offset, detonations.data(), detonations.size() * sizeof(Detonation));
+
+    // Unmap everything first, a chunk may come back in a different slot
+    for (int slot = 0; slot < MAX_RESIDENT_CHUNKS; slot++) {
+        if (slotChunks[slot] >= 0) {
+            chunkSlots[slotChunks[slot]] = -1;
+        }
+    }
+
+    for (int slot = 0; slot < MAX_RESIDENT_CHUNKS; slot++) {
+        int had = slotChunks[slot];
+        bool hadModified = slotModified[slot];
+        int chunk = header.slotChunks[slot];
+        slotChunks[slot] = chunk;
+        slotModified[slot] = header.slotModified[slot];
+        // Whatever left the slot may come back parked, or from the file,
+        // with other tiles than its layer shows
+        if (had >= 0 && had != chunk) {
+            InvalidateChunkLayer(had);
+        }
+        if (chunk < 0) continue;
+        chunkSlots[chunk] = slot;
+
+        Tile* scratch = restoreScratch.data();
+        if (header.slotModified[slot]) {
+            snapshot.Read(offset, scratch, CHUNK_TILES * sizeof(Tile));
+        } else if (had != chunk || hadModified) {
+            CopySourceChunk(chunk, scratch);
+        } else {
+            continue;  // same chunk, never touched
+        }
+
+        // Rolling back a few ticks changes a handful of tiles, queue just
+        // those for the cached layer instead of repainting the chunk
+        Tile* dest = &chunkPool[(size_t)slot * CHUNK_TILES];
+        if (had == chunk && hadModified == header.slotModified[slot] && FindChunkLayer(chunk) >= 0) {
+            int firstX = (chunk % chunksX) * CHUNK_SIZE;
+            int firstY = (chunk / chunksX) * CHUNK_SIZE;
+            for (int i = 0; i < CHUNK_TILES; i++) {
+                if (dest[i].type != scratch[i].type || dest[i].flags != scratch[i].flags) {
+                    dirtyTiles.push_back((firstY + (i >> CHUNK_SHIFT)) * width + firstX + (i & (CHUNK_SIZE - 1)));
                 }
             }
+        } else {
+            InvalidateChunkLayer(chunk);
         }
+        std::copy(scratch, scratch + CHUNK_TILES, dest);
     }
+
+    // Parked chunks have no layer of their own, but drop any left over
+    // from before they were parked
+    for (const auto& parked : modifiedChunks) {
+        InvalidateChunkLayer(parked.first);
+    }
+    modifiedChunks.clear();
+    for (uint32_t i = 0; i < header.parkedCount; i++) {
+        int chunk = 0;
+        snapshot.ReadValue(offset, chunk);
+        InvalidateChunkLayer(chunk);
+        std::vector<Tile>& tiles = modifiedChunks[chunk];
+        tiles.resize(CHUNK_TILES);
+        snapshot.Read(offset, tiles.data(), CHUNK_TILES * sizeof(Tile));
+    }
+    return true;
 }
 
-bool LevelManager::CheckCollisionWithBarrel(Vector2 position) {
-    Rectangle playerRect = {position.x - 15, position.y - 15, 30, 30};
+void LevelManager::CheckBulletCollisions() {
+    PROFILE_ZONE("CheckBulletCollisions");
+    const unsigned solidTiles = TileMask(TileType::WALL) | TileMask(TileType::DESTRUCTIBLE) |
+                                TileMask(TileType::BARREL) | TileMask(TileType::POWER_UP);
     
-    for (const auto& row : currentLevel) {
-        for (const auto& tile : row) {
-            if (!tile.destroyed && tile.type == TileType::BARREL && 
-                CheckCollisionRecs(playerRect, tile.rect)) {
-                return true;
+    for (size_t i = 0; i < bullets.Size(); i++) {
+        if (bullets.ShouldDestroy(i)) continue;
+
+        // Walk the cells the bullet crossed this tick so fast bullets can't
+        // skip over a tile, then fall back to the hitbox for grazing hits
+        int x = 0;
+        int y = 0;
+        if (!TraceTiles(bullets.GetPreviousPosition(i), bullets.GetPosition(i), solidTiles, x, y) &&
+            !FindTileInRect(bullets.GetHitbox(i), solidTiles, x, y)) {
+            continue;
+        }
+
+        TileType type = TileAt(x, y)->type;
+        if (type == TileType::WALL) {
+            bullets.MarkForDestruction(i);
+            continue;
+        }
+
+        // The power-up goes to whoever fired, if they are still around
+        if (type == TileType::POWER_UP && entities.IsAlive(bullets.GetOwner(i))) {
+            Weapon* weapon = entities.Weapons().Find(bullets.GetOwner(i).index);
+            if (weapon) {
+                weapon->powerUp = true;
             }
         }
+
+        // A power-up bullet blows up the tiles around the one it hit too,
+        // the blast goes off in UpdateExplosions
+        if (bullets.HasPowerUp(i)) {
+            QueueDetonation(x, y, powerUpBlastRadius);
+        }
+
+        // Start destruction animation instead of immediate destruction
+        StartTileAnimation(x, y);
+
+        bullets.MarkForDestruction(i);
+    }
+}
+
+bool LevelManager::TraceTiles(Vector2 from, Vector2 to, unsigned typeMask, int& hitX, int& hitY) const {
+    // Amanatides-Woo grid traversal: step cell by cell along the segment,
+    // always crossing whichever cell boundary comes first
+    float size = (float)tileSize;
+
+    int x = (int)std::floor(from.x / size);
+    int y = (int)std::floor(from.y / size);
+    int endX = (int)std::floor(to.x / size);
+    int endY = (int)std::floor(to.y / size);
+
+    float dx = to.x - from.x;
+    float dy = to.y - from.y;
+    int stepX = dx > 0 ? 1 : (dx < 0 ? -1 : 0);
+    int stepY = dy > 0 ? 1 : (dy < 0 ? -1 : 0);
+
+    // Segment parameter t (0..1) at the next x / y boundary, and per cell
+    float tMaxX = INFINITY;
+    float tMaxY = INFINITY;
+    float tDeltaX = INFINITY;
+    float tDeltaY = INFINITY;
+    if (stepX != 0) {
+        float boundary = (stepX > 0 ? x + 1 : x) * size;
+        tMaxX = (boundary - from.x) / dx;
+        tDeltaX = size / std::fabs(dx);
+    }
+    if (stepY != 0) {
+        float boundary = (stepY > 0 ? y + 1 : y) * size;
+        tMaxY = (boundary - from.y) / dy;
+        tDeltaY = size / std::fabs(dy);
+    }
+
+    int cellsLeft = std::abs(endX - x) + std::abs(endY - y);
+    while (true) {
+        const Tile* tile = GetTile(x, y);
+        if (tile && !(tile->flags & TILE_DESTROYED) && (typeMask & TileMask(tile->type))) {
+            hitX = x;
+            hitY = y;
+            return true;
+        }
+        if (cellsLeft-- <= 0) break;
+
+        if (tMaxX < tMaxY) {
+            tMaxX += tDeltaX;
+            x += stepX;
+        } else {
+            tMaxY += tDeltaY;
+            y += stepY;
+        }
     }
     return false;
 }
 
+bool LevelManager::CheckCollisionWithBarrel(Vector2 position) {
+    Rectangle playerRect = {position.x - 15, position.y - 15, 30, 30};
+    return CheckCollisionWithTiles(playerRect, TileMask(TileType::BARREL));
+}
+
 bool LevelManager::CheckCollisionWithObstacles(Vector2 position) {
     Rectangle playerRect = {position.x - 15, position.y - 15, 30, 30};
-    
-    for (const auto& row : currentLevel) {
-        for (const auto& tile : row) {
-            if (tile.destroyed) continue;
-            
-            // Check collision with barrels, walls, and destructible blocks
-            if ((tile.type == TileType::BARREL || tile.type == TileType::WALL || tile.type == TileType::DESTRUCTIBLE) &&
-                CheckCollisionRecs(playerRect, tile.rect)) {
+
+    // Check collision with barrels, walls, and destructible blocks
+    return CheckCollisionWithTiles(playerRect,
+        TileMask(TileType::BARREL) | TileMask(TileType::WALL) | TileMask(TileType::DESTRUCTIBLE));
+}
+
+TileRange LevelManager::GetTilesInRect(Rectangle rect) const {
+    TileRange range;
+    range.minX = std::max(0, (int)std::floor(rect.x / tileSize));
+    range.minY = std::max(0, (int)std::floor(rect.y / tileSize));
+    range.maxX = std::min(width - 1, (int)std::floor((rect.x + rect.width) / tileSize));
+    range.maxY = std::min(height - 1, (int)std::floor((rect.y + rect.height) / tileSize));
+    return range;
+}
+
+bool LevelManager::CheckCollisionWithTiles(Rectangle rect, unsigned typeMask) const {
+    int x = 0;
+    int y = 0;
+    return FindTileInRect(rect, typeMask, x, y);
+}
+
+bool LevelManager::FindTileInRect(Rectangle rect, unsigned typeMask, int& hitX, int& hitY) const {
+    TileRange range = GetTilesInRect(rect);
+
+    for (int y = range.minY; y <= range.maxY; y++) {
+        for (int x = range.minX; x <= range.maxX; x++) {
+            const Tile* tile = GetTile(x, y);
+            if (tile && !(tile->flags & TILE_DESTROYED) && (typeMask & TileMask(tile->type)) &&
+                CheckCollisionRecs(rect, GetTileRect(x, y))) {
+                hitX = x;
+                hitY = y;
                 return true;
             }
         }
     }
     return false;
 }
-
@@ -1,50 +1,325 @@
 #ifndef LEVELMANAGER_H
 #define LEVELMANAGER_H
 
-#include "Player.h"
+#include "BulletPool.h"
+#include "EntityStore.h"
+#include "FlowField.h"
+#include "LevelFile.h"
+#include "LevelFormat.h"
+#include "SimInput.h"
+#include "SpatialHash.h"
+#include "Snapshot.h"
 #include "raylib.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
-enum class TileType {
-    EMPTY,
-    WALL,
-    DESTRUCTIBLE,
-    BARREL,
-    POWER_UP,
-    SPAWN_POINT,
-    EXIT_POINT
+enum class LevelStatus {
+    RUNNING,
+    WON,
+    LOST
 };
 
-struct Tile {
-    TileType type;
+// Bit for a tile type, combine with | to query several types at once
+inline unsigned TileMask(TileType type) {
+    return 1u << static_cast<unsigned>(type);
+}
+
+enum class LevelEventType {
+    TILE_DESTROYED,
+    TILE_EXPLODING,  // destruction animation started, TILE_DESTROYED follows
+    PLAYER_MOVED,
+    ENTITY_DESTROYED
+};
+
+// Published by LevelManager as the simulation changes. tileX/tileY is the
+// destroyed or exploding tile, or the cell under the player or destroyed
+// entity; position is the player's or the destroyed entity's.
+struct LevelEvent {
+    LevelEventType type;
+    int tileX;
+    int tileY;
+    Vector2 position;
+};
+
+using LevelEventListener = std::function<void(const LevelEvent&)>;
+
+// Inclusive range of grid cells, already clamped to the level
+struct TileRange {
+    int minX;
+    int minY;
+    int maxX;
+    int maxY;
+};
+
+// A tile that is currently playing its destruction animation
+const float TILE_ANIMATION_TIME = 0.3f;  // seconds
+
+struct TileAnimation {
+    int index;
+    float timer;
+    float offset;
+};
+
+// A blast waiting in the explosion queue, centred on a tile
+struct Detonation {
+    int index;
+    int radius;
+};
+
+// Blasts destroy the destructibles and barrels within radius tiles (a
+// square, radius 1 is the 3x3 around the centre). Barrels caught in one
+// explode in turn when their animation ends, so a chain moves outwards one
+// ring per animation. Large chains are spread over ticks as well: at most
+// MAX_DETONATIONS_PER_TICK blasts go off per tick, the rest wait.
+const int BARREL_BLAST_RADIUS = 1;
+const int POWER_UP_BLAST_RADIUS = 1;
+const int MAX_BLAST_RADIUS = 8;
+const int MAX_DETONATIONS_PER_TICK = 128;
+
+// A tank bullets can hit this tick
+struct HitTarget {
     Rectangle rect;
-    bool destroyed;
-    bool animating;
-    float animationTimer;
-    float animationOffset;
+    uint8_t team;
+    uint32_t entity;
+};
+// Up to this many targets bullets test them all, more go through bodyHash
+const size_t HIT_SCAN_TARGETS = 16;
+
+// Tank defaults, the player can take a few more hits than the others
+const float TANK_SPEED = 180.0f;
+const float TANK_FIRE_COOLDOWN = 0.5f;
+const int PLAYER_HIT_POINTS = 3;
+const int TANK_HIT_POINTS = 1;
+// Enemies open fire when the player is lined up within this many tiles
+const int ENEMY_SIGHT_TILES = 8;
+
+// Levels are split into square chunks of CHUNK_SIZE tiles. Only the chunks
+// within STREAM_RADIUS chunks of the player are resident, the simulation
+// never looks at anything else.
+const int CHUNK_SHIFT = 5;
+const int CHUNK_SIZE = 1 << CHUNK_SHIFT;
+const int CHUNK_TILES = CHUNK_SIZE * CHUNK_SIZE;
+const int STREAM_RADIUS = 2;
+const int MAX_RESIDENT_CHUNKS = (2 * STREAM_RADIUS + 1) * (2 * STREAM_RADIUS + 1);
+// Cached chunk renders kept on the GPU, enough for a few screens
+const int MAX_CHUNK_LAYERS = 16;
+
+// Pre-rendered walls and untouched blocks of one chunk
+struct ChunkLayer {
+    int chunk;              // -1 when the slot holds nothing valid
+    RenderTexture2D target;
+    bool debug;
+    unsigned int atlas;     // atlas the layer was painted from
+    unsigned int lastUsed;  // draw frame, the oldest layer gets reused
 };
 
 class LevelManager {
 private:
-    std::vector<std::vector<Tile>> currentLevel;
-    Player player;
+    // Row-major, index = y * width + x. Points into the mapped level file,
+    // or into generatedTiles for levels built in memory. Never written,
+    // play happens on the resident chunk copies.
+    const Tile* sourceTiles;
+    LevelFile levelFile;
+    std::vector<Tile> generatedTiles;
+
+    // Streaming state. chunkSlots maps every chunk of the level to its slot
+    // in chunkPool, or -1 while it isn't loaded. Chunks that had tiles
+    // destroyed are parked in modifiedChunks when evicted so the damage
+    // survives the player walking away.
+    int chunksX;
+    int chunksY;
+    int streamCenter;  // chunk the resident window is centred on
+    std::vector<int> chunkSlots;
+    std::vector<Tile> chunkPool;  // MAX_RESIDENT_CHUNKS * CHUNK_TILES
+    std::vector<int> slotChunks;  // chunk held by each slot, -1 if free
+    std::vector<bool> slotModified;
+    std::unordered_map<int, std::vector<Tile>> modifiedChunks;
+    std::vector<Tile> restoreScratch;  // one chunk, used by RestoreSnapshot
+    EntityStore restoreEntities;       // checked there before it is swapped in
+    // Only the tiles that are exploding right now, in no particular order
+    std::vector<TileAnimation> activeAnimations;
+    // Blasts still to go off, oldest first from detonationHead. A tile
+    // only starts animating once, so its flags keep a chain from visiting
+    // it again.
+    std::vector<Detonation> detonations;
+    size_t detonationHead;
+    int barrelBlastRadius;
+    int powerUpBlastRadius;
+    int width;
+    int height;
+    // Tanks and other objects. player is the one driven by SimInput, it is
+    // created first on every load and never destroyed during a level.
+    EntityStore entities;
+    Entity player;
+    // Shared by every tank, each bullet remembers who fired it
+    BulletPool bullets;
+    std::vector<HitTarget> hitTargets;  // scratch for CheckBulletHits
+    // Rebuilt by each system that needs it, so tanks only test the tanks
+    // and bullets only the targets in the same few cells
+    SpatialHash bodyHash;
+    // Distance to the player over the resident chunks, shared by every
+    // path follower. Rebuilt when the resident window moves, repaired when
+    // a tile is destroyed or the player changes cell.
+    FlowField flowField;
+    bool flowFieldValid;
+    // Showing a match server's state, see SetRemoteView
+    bool remoteView;
     Vector2 exitPoint;
     int tileSize;
+    float elapsedTime;
+    float timeLimit;
+    LevelStatus status;
+    size_t bulletCapacity;
+
+    // Kept up to date from events so status checks never rescan the grid
+    int remainingDestructibles;
+    bool playerDead;
+    bool playerOnExit;
+    std::vector<LevelEventListener> listeners;
+
+    // Static tiles are rendered once per visible chunk. Tiles that start
+    // exploding are queued in dirtyTiles and cleared from their chunk's
+    // layer on the next draw, the explosion is drawn on top every frame.
+    ChunkLayer chunkLayers[MAX_CHUNK_LAYERS];
+    unsigned int drawFrame;
+    std::vector<int> dirtyTiles;
+    int FindChunkLayer(int chunk) const;
+    ChunkLayer& AcquireChunkLayer(int chunk, bool debugMode);
+    void PaintChunkLayer(ChunkLayer& layer, bool debugMode);
+    void FlushDirtyTiles(bool debugMode);
+
+    Tile* TileAt(int x, int y);
+    void UpdateStreaming();
+    void LoadChunk(int chunk);
+    void EvictChunk(int chunk);
+    void CopySourceChunk(int chunk, Tile* dest) const;
+    void InvalidateChunkLayer(int chunk);
+    void SpawnChunkEnemies(int chunk);
+    void RebuildFlowField();
+
+    void ResetLevelState(const LevelHeader& header);
+    // Systems, run in this order by Update over the packed components
+    void UpdatePathFollowers(float dt);
+    void UpdateMovement(float dt);
+    bool IsBlockedByBody(uint32_t entity, Vector2 from, Vector2 to);
+    void UpdateWeapons(float dt);
+    void CheckBulletHits();
+    void UpdateExplosions();
+    void RemoveDeadEntities();
+    void DestroyTile(int index);
+    void QueueDetonation(int x, int y, int radius);
+    void DrawTile(TileType type, Rectangle rect, bool debugMode);
+    void RefreshPlayerState();
+    void Publish(const LevelEvent& event);
+    void UpdateStatus();
     
 public:
     LevelManager();
-    void LoadLevel(int levelNumber);
-    void Update();
-    void UpdateTileAnimations();
+    LevelManager(const LevelManager&) = delete;
+    LevelManager& operator=(const LevelManager&) = delete;
+    // Maps a .bbl file and plays on it directly
+    bool LoadLevel(const std::string& path);
+    // Copies a level built in memory (tools, generated maps)
+    void LoadLevel(const LevelHeader& header, const Tile* levelTiles);
+    // Advances the simulation by dt seconds. Never touches the window,
+    // keyboard or frame clock, so it can run without InitWindow.
+    void Update(const SimInput& input, float dt);
+    void UpdateTileAnimations(float dt);
+    // Starts the destruction animation of a resident tile, the tile is
+    // destroyed when it finishes. Does nothing for tiles already going.
+    void StartTileAnimation(int x, int y);
+    // Bullets all tanks together can have in flight, applies from the next
+    // LoadLevel
+    void SetBulletCapacity(size_t capacity);
+    // In tiles, clamped to 0..MAX_BLAST_RADIUS. Applies to blasts queued
+    // from now on.
+    void SetBlastRadius(int barrelRadius, int powerUpRadius);
+    // Blasts queued but not gone off yet
+    size_t GetPendingDetonations() const;
+    // A tank with every component. Set its Velocity move and Weapon trigger
+    // to drive it; it only moves and fires while inside the resident chunks.
+    Entity SpawnTank(Vector2 position, uint8_t team, int hitPoints = TANK_HIT_POINTS);
+    // An enemy tank that drives itself toward the player along the flow
+    // field and fires when the player is lined up in front of it
+    Entity SpawnEnemy(Vector2 position);
+    // Moves an entity without collision checks or interpolation
+    void TeleportEntity(Entity entity, Vector2 position);
+
+    // Remote play: the level only shows what a match server simulated.
+    // Update does nothing and chunks that load spawn no enemies; the
+    // client moves the player, other tanks and bullets itself and puts
+    // tiles in place with SetRemoteTile. Set it before LoadLevel, it stays
+    // on across loads.
+    void SetRemoteView(bool remote);
+    bool IsRemoteView() const;
+    // Sets a tile's flags, also in chunks that aren't resident. Starts or
+    // ends the tile's animation to match.
+    void SetRemoteTile(int x, int y, uint8_t flags);
+    // Streams around the player and plays the tile animations without
+    // destroying anything, once per frame in remote view
+    void UpdateRemoteView(float dt);
+    // The draw functions are in LevelDraw.cpp, outside bomber_sim
     void Draw();
-    void DrawDebug(bool debugMode);
-    Player& GetPlayer();
-    bool AreAllDestructiblesDestroyed();
-    bool IsPlayerDead();
-    bool IsPlayerOnExit();
+    // view is the visible part of the world, nothing outside it is drawn
+    void DrawDebug(bool debugMode, Rectangle view);
+    // Tanks and bullets, blended alpha of the way into the next tick
+    void DrawEntities(bool debugMode, float alpha, Rectangle view);
+    // Frees GPU resources, call before the window closes
+    void UnloadDrawResources();
+    Entity GetPlayer() const;
+    // Blended the same way DrawEntities does, for the camera
+    Vector2 GetPlayerPosition(float alpha = 1.0f) const;
+    Vector2 GetEntityPosition(Entity entity, float alpha = 1.0f) const;
+    EntityStore& GetEntities();
+    const EntityStore& GetEntities() const;
+    BulletPool& GetBullets();
+    // Only kept up to date while there are path followers
+    const FlowField& GetFlowField() const;
+    const BulletPool& GetBullets() const;
+    LevelStatus GetStatus() const;
+    float GetTimeRemaining() const;
+    int GetWidth() const;
+    int GetHeight() const;
+    int GetTileSize() const;
+    // nullptr outside the level or in a chunk that isn't resident
+    const Tile* GetTile(int x, int y) const;
+    Rectangle GetTileRect(int x, int y) const;
+    Rectangle GetWorldBounds() const;
+    // World area covered by the resident chunks, bullets die at its edge
+    Rectangle GetActiveBounds() const;
+    int GetResidentChunkCount() const;
+    void AddListener(LevelEventListener listener);
+    bool AreAllDestructiblesDestroyed() const;
+    int GetRemainingDestructibles() const;
+    bool IsPlayerDead() const;
+    bool IsPlayerOnExit() const;
+    // Hash of everything the simulation depends on. Two runs that got the
+    // same inputs on the same level must agree on it tick for tick.
+    uint64_t GetStateHash() const;
+    // Copies the whole simulation state into a flat buffer. Chunks that
+    // still match the level file are stored as a chunk index only, so a
+    // snapshot is a few KB even on large maps.
+    void SaveSnapshot(Snapshot& snapshot) const;
+    // Puts the state back, including residency. Returns false, changing
+    // nothing, if the snapshot was taken on a level of another size or
+    // with another bullet capacity, is cut short, or doesn't hold together
+    // (no live player tank, indices or tile types out of range).
+    bool RestoreSnapshot(const Snapshot& snapshot);
     void CheckBulletCollisions();
     bool CheckCollisionWithBarrel(Vector2 position);
     bool CheckCollisionWithObstacles(Vector2 position);
+
+    // Grid queries: only the cells under the rect are visited, so the cost
+    // does not depend on the map size. Cells of chunks that aren't resident
+    // are skipped.
+    TileRange GetTilesInRect(Rectangle rect) const;
+    bool CheckCollisionWithTiles(Rectangle rect, unsigned typeMask) const;
+    bool FindTileInRect(Rectangle rect, unsigned typeMask, int& hitX, int& hitY) const;
+    // First tile of the given types crossed by the segment from -> to
+    bool TraceTiles(Vector2 from, Vector2 to, unsigned typeMask, int& hitX, int& hitY) const;
 };
 
 #endif
@@ -0,0 +1,351 @@
+#include "MatchClient.h"
+#include "Replay.h"
+#include <algorithm>
+
+MatchClient::MatchClient() : server{0, 0}, state(ClientState::DISCONNECTED), clock(0), lastHeard(0), lastHello(0),
+                             slot(-1), bulletCapacity(0), latestSequence(0), previousSequence(0), latestTime(0),
+                             inputSequence(0), inputAck(0), inputLatency(0), shownMatch(0), shownSequence(0),
+                             shownTiles(0), showStamp(0), ownTank(INVALID_ENTITY), bytesSent(0), bytesReceived(0),
+                             snapshotsReceived(0), fullSnapshotsReceived(0), snapshotsRejected(0) {}
+
+MatchClient::~MatchClient() {
+    Disconnect();
+}
+
+bool MatchClient::Connect(const std::string& address, std::string& errorOut) {
+    Disconnect();
+    if (!ParseAddress(address, NET_DEFAULT_PORT, server, errorOut) || !socket.Open(0, errorOut)) {
+        return false;
+    }
+
+    state = ClientState::CONNECTING;
+    error.clear();
+    clock = 0;
+    lastHeard = 0;
+    slot = -1;
+    for (NetState& snapshot : history) {
+        ResetNetState(snapshot);
+    }
+    tileLog.clear();
+    latestSequence = 0;
+    previousSequence = 0;
+    inputSequence = 0;
+    inputAck = 0;
+    inputLatency = 0;
+    shownMatch = 0;
+    shownSequence = 0;
+    ownTank = INVALID_ENTITY;
+    shownTanks.clear();
+    bytesSent = 0;
+    bytesReceived = 0;
+    snapshotsReceived = 0;
+    fullSnapshotsReceived = 0;
+    snapshotsRejected = 0;
+    SendHello();
+    return true;
+}
+
+void MatchClient::Disconnect() {
+    if (state == ClientState::CONNECTED) {
+        writer.Clear();
+        writer.U8((uint8_t)NetMessage::DISCONNECT);
+        Send();
+    }
+    socket.Close();
+    state = ClientState::DISCONNECTED;
+}
+
+void MatchClient::Fail(const std::string& reason) {
+    error = reason;
+    socket.Close();
+    state = ClientState::DISCONNECTED;
+}
+
+void MatchClient::Update(float dt) {
+    if (state == ClientState::DISCONNECTED) return;
+    clock += dt;
+
+    NetAddress from = {};
+    size_t size = 0;
+    while (state != ClientState::DISCONNECTED &&
+           (size = socket.Receive(from, receiveBuffer, sizeof(receiveBuffer))) > 0) {
+        if (from != server) continue;
+        bytesReceived += size;
+        lastHeard = clock;
+
+        NetReader in(receiveBuffer, size);
+        switch ((NetMessage)in.U8()) {
+            case NetMessage::WELCOME:
+                HandleWelcome(in);
+                break;
+            case NetMessage::REJECT:
+                Fail(in.U8() == (uint8_t)NetRejectReason::FULL ? "the match is full" : "the server runs another version");
+                break;
+            case NetMessage::SNAPSHOT:
+                HandleSnapshot(in);
+                break;
+            case NetMessage::DISCONNECT:
+                Fail("the server closed the match");
+                break;
+            default:
+                break;
+        }
+    }
+    if (state == ClientState::DISCONNECTED) return;
+
+    if (state == ClientState::CONNECTING && clock - lastHello >= NET_HELLO_INTERVAL) {
+        SendHello();
+    }
+    if (clock - lastHeard > NET_TIMEOUT) {
+        Fail("the server stopped answering");
+    }
+}
+
+void MatchClient::HandleWelcome(NetReader& in) {
+    if (state != ClientState::CONNECTING) return;
+    uint16_t version = in.U16();
+    int welcomeSlot = in.U8();
+    uint32_t capacity = in.VarUint();
+    std::string path = in.String();
+    if (in.Failed() || version != NET_PROTOCOL_VERSION || path.empty()) return;
+
+    slot = welcomeSlot;
+    bulletCapacity = capacity;
+    levelPath = path;
+    state = ClientState::CONNECTED;
+}
+
+void MatchClient::HandleSnapshot(NetReader& in) {
+    if (state != ClientState::CONNECTED) return;
+
+    // Late ones are of no use, and would cut the tile log back
+    NetReader header = in;
+    uint32_t sequence = header.VarUint();
+    uint32_t baseline = header.VarUint();
+    if (header.Failed() || sequence <= latestSequence) return;
+
+    if (!ReadSnapshot(in, history, tileLog, decoded)) {
+        snapshotsRejected++;
+        return;
+    }
+    std::swap(history[sequence % NET_HISTORY], decoded);
+    previousSequence = latestSequence;
+    latestSequence = sequence;
+    latestTime = clock;
+    snapshotsReceived++;
+    if (baseline == 0) {
+        fullSnapshotsReceived++;
+    }
+
+    const NetState& latest = history[sequence % NET_HISTORY];
+    if (latest.inputAck > inputAck && latest.inputAck <= inputSequence) {
+        inputAck = latest.inputAck;
+        if (inputSequence - inputAck < INPUT_RING) {
+            inputLatency = clock - sentTimes[inputAck % INPUT_RING];
+        }
+    }
+}
+
+void MatchClient::SendHello() {
+    lastHello = clock;
+    writer.Clear();
+    writer.U8((uint8_t)NetMessage::HELLO);
+    writer.U16(NET_PROTOCOL_VERSION);
+    Send();
+}
+
+void MatchClient::Send() {
+    socket.Send(server, writer.Data(), writer.Size());
+    bytesSent += writer.Size();
+}
+
+void MatchClient::SendInput(const SimInput& input) {
+    if (state != ClientState::CONNECTED) return;
+    inputSequence++;
+    sentInputs[inputSequence % INPUT_RING] = PackInput(input);
+    sentTimes[inputSequence % INPUT_RING] = clock;
+
+    // The last few inputs again, so one lost message loses nothing
+    uint32_t count = std::min<uint32_t>(inputSequence, NET_INPUT_REDUNDANCY);
+    writer.Clear();
+    writer.U8((uint8_t)NetMessage::INPUT);
+    writer.VarUint(latestSequence);
+    writer.VarUint(inputSequence);
+    writer.U8((uint8_t)count);
+    for (uint32_t sequence = inputSequence - count + 1; sequence <= inputSequence; sequence++) {
+        writer.U8(sentInputs[sequence % INPUT_RING]);
+    }
+    Send();
+}
+
+bool MatchClient::ApplyTo(LevelManager& level) {
+    if (state != ClientState::CONNECTED || latestSequence == 0) return true;
+    const NetState& latest = history[latestSequence % NET_HISTORY];
+
+    if (latest.match != shownMatch) {
+        level.SetRemoteView(true);
+        level.SetBulletCapacity(bulletCapacity);
+        if (!level.LoadLevel(levelPath)) {
+            Disconnect();
+            error = "cannot load " + levelPath;
+            return false;
+        }
+        shownMatch = latest.match;
+        shownSequence = 0;
+        shownTiles = 0;
+        shownTanks.clear();
+    }
+    if (shownSequence == latestSequence) return true;
+    shownSequence = latestSequence;
+
+    // Entries past the snapshot's cursor may still be cut back
+    int width = level.GetWidth();
+    for (; shownTiles < latest.tileCursor && shownTiles < tileLog.size(); shownTiles++) {
+        int index = TileChangeIndex(tileLog[shownTiles]);
+        level.SetRemoteTile(index % width, index / width, TileChangeFlags(tileLog[shownTiles]));
+    }
+
+    const NetState& previous = history[previousSequence % NET_HISTORY];
+    bool blend = previousSequence != 0 && previous.sequence == previousSequence && previous.match == latest.match;
+    ShowTanks(level, blend ? previous : latest, latest);
+    ShowBullets(level, blend ? previous : latest, latest);
+    return true;
+}
+
+void MatchClient::ShowTanks(LevelManager& level, const NetState& previous, const NetState& latest) {
+    EntityStore& entities = level.GetEntities();
+    showStamp++;
+    ownTank = INVALID_ENTITY;
+
+    size_t p = 0;
+    for (const NetTank& tank : latest.tanks) {
+        while (p < previous.tanks.size() && previous.tanks[p].id < tank.id) p++;
+        const NetTank& from = p < previous.tanks.size() && previous.tanks[p].id == tank.id &&
+                              previous.tanks[p].generation == tank.generation ? previous.tanks[p] : tank;
+        Vector2 position = {FromNetPosition(tank.x), FromNetPosition(tank.y)};
+
+        // The level's player is already there, the rest come and go
+        Entity entity = level.GetPlayer();
+        if (tank.id != latest.playerTank) {
+            auto found = shownTanks.find(tank.id);
+            if (found != shownTanks.end() &&
+                (found->second.generation != tank.generation || !entities.IsAlive(found->second.entity))) {
+                entities.Destroy(found->second.entity);
+                shownTanks.erase(found);
+                found = shownTanks.end();
+            }
+            if (found == shownTanks.end()) {
+                Entity spawned = level.SpawnTank(position, tank.team, tank.hitPoints);
+                found = shownTanks.emplace(tank.id, ShownTank{tank.generation, spawned, 0}).first;
+            }
+            found->second.stamp = showStamp;
+            entity = found->second.entity;
+        }
+
+        Transform* transform = entities.Transforms().Find(entity.index);
+        transform->previousPosition = {FromNetPosition(from.x), FromNetPosition(from.y)};
+        transform->position = position;
+        transform->direction = UnpackInput(tank.direction).move;
+        entities.Healths().Find(entity.index)->hitPoints = tank.hitPoints;
+        if (tank.id == latest.ownTank) {
+            ownTank = entity;
+        }
+    }
+
+    for (auto it = shownTanks.begin(); it != shownTanks.end();) {
+        if (it->second.stamp != showStamp) {
+            entities.Destroy(it->second.entity);
+            it = shownTanks.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void MatchClient::ShowBullets(LevelManager& level, const NetState& previous, const NetState& latest) {
+    BulletPool& bullets = level.GetBullets();
+    bullets.Clear();
+
+    size_t p = 0;
+    for (const NetBullet& bullet : latest.bullets) {
+        while (p < previous.bullets.size() && previous.bullets[p].id < bullet.id) p++;
+        const NetBullet& from = p < previous.bullets.size() && previous.bullets[p].id == bullet.id &&
+                                previous.bullets[p].generation == bullet.generation ? previous.bullets[p] : bullet;
+
+        Vector2 position = {FromNetPosition(bullet.x), FromNetPosition(bullet.y)};
+        if (bullets.Spawn(position, {0, 0}, bullet.powerUp != 0, INVALID_ENTITY, bullet.team).slot == UINT32_MAX) break;
+        bullets.SetPositions(bullets.Size() - 1, {FromNetPosition(from.x), FromNetPosition(from.y)}, position);
+    }
+}
+
+ClientState MatchClient::GetState() const {
+    return state;
+}
+
+const std::string& MatchClient::GetError() const {
+    return error;
+}
+
+bool MatchClient::HasSnapshot() const {
+    return latestSequence != 0;
+}
+
+float MatchClient::GetInterpolation() const {
+    if (latestSequence == 0) return 1.0f;
+    return std::clamp((clock - latestTime) / (NET_SNAPSHOT_INTERVAL * SIM_TIMESTEP), 0.0f, 1.0f);
+}
+
+Entity MatchClient::GetOwnTank() const {
+    return ownTank;
+}
+
+int MatchClient::GetSlot() const {
+    return slot;
+}
+
+LevelStatus MatchClient::GetStatus() const {
+    if (latestSequence == 0) return LevelStatus::RUNNING;
+    return (LevelStatus)history[latestSequence % NET_HISTORY].status;
+}
+
+float MatchClient::GetTimeRemaining() const {
+    if (latestSequence == 0) return 0;
+    return history[latestSequence % NET_HISTORY].timeLeft / 10.0f;
+}
+
+uint32_t MatchClient::GetLatestTick() const {
+    if (latestSequence == 0) return 0;
+    return history[latestSequence % NET_HISTORY].tick;
+}
+
+float MatchClient::GetInputLatency() const {
+    return inputLatency;
+}
+
+uint32_t MatchClient::GetInputAck() const {
+    return inputAck;
+}
+
+size_t MatchClient::GetTileLogSize() const {
+    return tileLog.size();
+}
+
+uint64_t MatchClient::GetBytesSent() const {
+    return bytesSent;
+}
+
+uint64_t MatchClient::GetBytesReceived() const {
+    return bytesReceived;
+}
+
+uint32_t MatchClient::GetSnapshotsReceived() const {
+    return snapshotsReceived;
+}
+
+uint32_t MatchClient::GetFullSnapshotsReceived() const {
+    return fullSnapshotsReceived;
+}
+
+uint32_t MatchClient::GetSnapshotsRejected() const {
+    return snapshotsRejected;
+}
@@ -0,0 +1,131 @@
+#ifndef MATCHCLIENT_H
+#define MATCHCLIENT_H
+
+#include "LevelManager.h"
+#include "NetProtocol.h"
+#include "NetSocket.h"
+#include "SimInput.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class ClientState {
+    DISCONNECTED,
+    CONNECTING,
+    CONNECTED
+};
+
+// Seconds between hellos while the server hasn't answered
+const float NET_HELLO_INTERVAL = 0.5f;
+// Inputs remembered for round trip times, more than can be in flight
+const int INPUT_RING = 128;
+
+// Plays in a MatchServer's match. Update reads what the server sent,
+// SendInput sends one tick of input, ApplyTo puts the newest snapshots on
+// a LevelManager in remote view, which then draws them as usual. Nothing
+// is simulated here; tanks are drawn between the two newest snapshots.
+class MatchClient {
+private:
+    // Server tank shown as a local entity
+    struct ShownTank {
+        uint32_t generation;
+        Entity entity;
+        uint32_t stamp;  // last ApplyTo that saw it
+    };
+
+    NetSocket socket;
+    NetAddress server;
+    ClientState state;
+    std::string error;
+    float clock;  // seconds since Connect
+    float lastHeard;
+    float lastHello;
+    int slot;
+    size_t bulletCapacity;
+    std::string levelPath;
+
+    NetState history[NET_HISTORY];  // decoded, by sequence % NET_HISTORY
+    NetState decoded;               // scratch, swapped into history
+    std::vector<uint32_t> tileLog;
+    uint32_t latestSequence;        // 0 before the first snapshot
+    uint32_t previousSequence;      // drawn at interpolation 0, latest at 1
+    float latestTime;
+
+    uint8_t sentInputs[INPUT_RING];  // by sequence % INPUT_RING
+    float sentTimes[INPUT_RING];
+    uint32_t inputSequence;
+    uint32_t inputAck;
+    float inputLatency;
+
+    // What ApplyTo has put on the level
+    uint32_t shownMatch;
+    uint32_t shownSequence;
+    size_t shownTiles;
+    uint32_t showStamp;
+    std::unordered_map<uint32_t, ShownTank> shownTanks;
+    Entity ownTank;
+
+    NetWriter writer;
+    unsigned char receiveBuffer[2048];
+    uint64_t bytesSent;
+    uint64_t bytesReceived;
+    uint32_t snapshotsReceived;
+    uint32_t fullSnapshotsReceived;
+    uint32_t snapshotsRejected;
+
+    void HandleWelcome(NetReader& in);
+    void HandleSnapshot(NetReader& in);
+    void SendHello();
+    void Send();
+    void Fail(const std::string& reason);
+    void ShowTanks(LevelManager& level, const NetState& previous, const NetState& latest);
+    void ShowBullets(LevelManager& level, const NetState& previous, const NetState& latest);
+
+public:
+    MatchClient();
+    ~MatchClient();
+    MatchClient(const MatchClient&) = delete;
+    MatchClient& operator=(const MatchClient&) = delete;
+
+    // "host:port" or "host" for NET_DEFAULT_PORT. Only starts saying
+    // hello, Update finishes connecting.
+    bool Connect(const std::string& address, std::string& error);
+    // Tells the server, if connected
+    void Disconnect();
+    // Reads everything the server sent, says hello again while connecting
+    // and gives up once the server has been quiet for NET_TIMEOUT
+    void Update(float dt);
+    // Input for one simulation tick, call at the simulation rate
+    void SendInput(const SimInput& input);
+    // Brings level up to the newest snapshot, loading the server's level
+    // into it (in remote view) at the start of every match. False, and
+    // disconnected, if the level can't be loaded.
+    bool ApplyTo(LevelManager& level);
+
+    ClientState GetState() const;
+    // Why the client disconnected, empty if it was asked to
+    const std::string& GetError() const;
+    bool HasSnapshot() const;
+    // Where to draw between the previous snapshot (0) and the newest (1)
+    float GetInterpolation() const;
+    // Local entity of the client's tank as of the last ApplyTo,
+    // INVALID_ENTITY when it has none
+    Entity GetOwnTank() const;
+    int GetSlot() const;
+    LevelStatus GetStatus() const;
+    float GetTimeRemaining() const;
+    uint32_t GetLatestTick() const;
+    // Seconds from sending an input until a snapshot said it was used
+    float GetInputLatency() const;
+    uint32_t GetInputAck() const;
+    size_t GetTileLogSize() const;
+    uint64_t GetBytesSent() const;
+    uint64_t GetBytesReceived() const;
+    uint32_t GetSnapshotsReceived() const;
+    uint32_t GetFullSnapshotsReceived() const;
+    // Malformed, or encoded against a snapshot no longer kept
+    uint32_t GetSnapshotsRejected() const;
+};
+
+#endif
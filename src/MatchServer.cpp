@@ -0,0 +1,409 @@
+#include "MatchServer.h"
+#include "Profiler.h"
+#include "Replay.h"
+#include <algorithm>
+#include <cmath>
+
+const int RESTART_TICKS = (int)(MATCH_RESTART_DELAY / SIM_TIMESTEP);
+const uint32_t TIMEOUT_TICKS = (uint32_t)(NET_TIMEOUT / SIM_TIMESTEP);
+const uint8_t PACKED_SHOT = 1 << 4;  // PackInput's shot bit
+
+MatchServer::MatchServer() : tick(0), match(0), restartTicks(RESTART_TICKS), spawnPosition{0, 0},
+                             bytesSent(0), bytesReceived(0), snapshotsSent(0), fullSnapshotsSent(0) {
+    clients.resize(NET_MAX_CLIENTS);
+    for (Client& client : clients) {
+        client.connected = false;
+    }
+    ResetNetState(none);
+
+    // Every tile change goes in the log the snapshots are cut from
+    level.AddListener([this](const LevelEvent& event) {
+        int index = event.tileY * level.GetWidth() + event.tileX;
+        if (event.type == LevelEventType::TILE_DESTROYED) {
+            tileLog.push_back(PackTileChange(index, TILE_DESTROYED));
+        } else if (event.type == LevelEventType::TILE_EXPLODING) {
+            tileLog.push_back(PackTileChange(index, TILE_ANIMATING));
+        }
+    });
+}
+
+MatchServer::~MatchServer() {
+    Stop();
+}
+
+bool MatchServer::Start(const std::string& path, uint16_t port, std::string& error) {
+    levelPath = path;
+    tileLog.clear();
+    if (!level.LoadLevel(levelPath)) {
+        error = "cannot load " + levelPath;
+        return false;
+    }
+    if (!socket.Open(port, error)) {
+        return false;
+    }
+
+    tick = 0;
+    match = 1;
+    restartTicks = RESTART_TICKS;
+    spawnPosition = level.GetPlayerPosition();
+    for (Client& client : clients) {
+        client.connected = false;
+    }
+    return true;
+}
+
+void MatchServer::Stop() {
+    if (!socket.IsOpen()) return;
+    for (Client& client : clients) {
+        if (!client.connected) continue;
+        writer.Clear();
+        writer.U8((uint8_t)NetMessage::DISCONNECT);
+        Send(client.address);
+        client.connected = false;
+    }
+    socket.Close();
+}
+
+void MatchServer::Tick() {
+    PROFILE_ZONE("MatchServer::Tick");
+    if (!socket.IsOpen()) return;
+    ReceiveMessages();
+    tick++;
+
+    for (int slot = 0; slot < NET_MAX_CLIENTS; slot++) {
+        if (clients[slot].connected && tick - clients[slot].lastHeard > TIMEOUT_TICKS) {
+            Disconnect(slot);
+        }
+    }
+    // Nobody to play for, wait with the clock stopped
+    if (GetClientCount() == 0) return;
+
+    if (level.GetStatus() == LevelStatus::RUNNING) {
+        SimInput input = ApplyInputs();
+        level.Update(input, SIM_TIMESTEP);
+    } else if (--restartTicks <= 0) {
+        Restart();
+    }
+
+    if (tick % NET_SNAPSHOT_INTERVAL == 0) {
+        CaptureWorld();
+        SendSnapshots();
+    }
+}
+
+void MatchServer::ReceiveMessages() {
+    NetAddress from = {};
+    size_t size = 0;
+    while ((size = socket.Receive(from, receiveBuffer, sizeof(receiveBuffer))) > 0) {
+        bytesReceived += size;
+        NetReader in(receiveBuffer, size);
+        NetMessage type = (NetMessage)in.U8();
+        if (type == NetMessage::HELLO) {
+            HandleHello(from, in);
+            continue;
+        }
+
+        // Everything else only from clients that said hello
+        int slot = 0;
+        while (slot < NET_MAX_CLIENTS && !(clients[slot].connected && clients[slot].address == from)) {
+            slot++;
+        }
+        if (slot == NET_MAX_CLIENTS) continue;
+
+        clients[slot].lastHeard = tick;
+        if (type == NetMessage::INPUT) {
+            HandleInput(clients[slot], in);
+        } else if (type == NetMessage::DISCONNECT) {
+            Disconnect(slot);
+        }
+    }
+}
+
+void MatchServer::HandleHello(const NetAddress& from, NetReader& in) {
+    uint16_t version = in.U16();
+    if (in.Failed() || version != NET_PROTOCOL_VERSION) {
+        SendReject(from, NetRejectReason::VERSION);
+        return;
+    }
+
+    // The welcome may have been lost, say it again
+    int free = -1;
+    for (int slot = 0; slot < NET_MAX_CLIENTS; slot++) {
+        if (clients[slot].connected && clients[slot].address == from) {
+            clients[slot].lastHeard = tick;
+            SendWelcome(slot);
+            return;
+        }
+        if (!clients[slot].connected && free < 0) {
+            free = slot;
+        }
+    }
+    if (free < 0) {
+        SendReject(from, NetRejectReason::FULL);
+        return;
+    }
+
+    Client& client = clients[free];
+    client.connected = true;
+    client.address = from;
+    client.lastHeard = tick;
+    client.nextSequence = 1;
+    client.ackedSequence = 0;
+    client.inputSequence = 0;
+    client.usedInputSequence = 0;
+    client.inputs.clear();
+    client.lastInput = 0;
+    for (NetState& state : client.history) {
+        ResetNetState(state);
+    }
+    SpawnClientTank(free);
+    SendWelcome(free);
+}
+
+void MatchServer::HandleInput(Client& client, NetReader& in) {
+    uint32_t ack = in.VarUint();
+    uint32_t newest = in.VarUint();
+    uint8_t count = in.U8();
+    uint8_t inputs[NET_INPUT_REDUNDANCY];
+    if (count > NET_INPUT_REDUNDANCY || count > newest) return;
+    for (uint8_t i = 0; i < count; i++) {
+        inputs[i] = in.U8();
+    }
+    if (in.Failed()) return;
+
+    // Messages can arrive out of order, only ever move forward
+    if (ack > client.ackedSequence && ack < client.nextSequence) {
+        client.ackedSequence = ack;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        uint32_t sequence = newest - count + 1 + i;
+        if (sequence <= client.inputSequence) continue;
+        client.inputs.push_back({sequence, inputs[i]});
+        client.inputSequence = sequence;
+    }
+    while (client.inputs.size() > MAX_QUEUED_INPUTS) {
+        client.inputs.pop_front();
+    }
+}
+
+void MatchServer::SendWelcome(int slot) {
+    writer.Clear();
+    writer.U8((uint8_t)NetMessage::WELCOME);
+    writer.U16(NET_PROTOCOL_VERSION);
+    writer.U8((uint8_t)slot);
+    writer.VarUint((uint32_t)level.GetBullets().Capacity());
+    writer.String(levelPath);
+    Send(clients[slot].address);
+}
+
+void MatchServer::SendReject(const NetAddress& to, NetRejectReason reason) {
+    writer.Clear();
+    writer.U8((uint8_t)NetMessage::REJECT);
+    writer.U8((uint8_t)reason);
+    Send(to);
+}
+
+void MatchServer::Send(const NetAddress& to) {
+    socket.Send(to, writer.Data(), writer.Size());
+    bytesSent += writer.Size();
+}
+
+void MatchServer::Disconnect(int slot) {
+    Client& client = clients[slot];
+    client.connected = false;
+    // The level's player stays for the next one to take over
+    if (slot > 0) {
+        level.GetEntities().Destroy(client.tank);
+    }
+    client.tank = INVALID_ENTITY;
+}
+
+void MatchServer::SpawnClientTank(int slot) {
+    clients[slot].tank = slot == 0 ? level.GetPlayer() : level.SpawnTank(spawnPosition, TEAM_PLAYER, PLAYER_HIT_POINTS);
+}
+
+void MatchServer::Restart() {
+    // Loading clears every tank, the connected clients get new ones
+    tileLog.clear();
+    if (!level.LoadLevel(levelPath)) {
+        // LoadLevel has logged why, nothing left to play on
+        Stop();
+        return;
+    }
+    match++;
+    restartTicks = RESTART_TICKS;
+    spawnPosition = level.GetPlayerPosition();
+    for (int slot = 0; slot < NET_MAX_CLIENTS; slot++) {
+        Client& client = clients[slot];
+        if (!client.connected) continue;
+        SpawnClientTank(slot);
+        // Nothing from the old match is a baseline anymore
+        client.ackedSequence = 0;
+        for (NetState& state : client.history) {
+            ResetNetState(state);
+        }
+    }
+}
+
+SimInput MatchServer::ApplyInputs() {
+    SimInput playerInput = {{0, 0}, false};
+    EntityStore& entities = level.GetEntities();
+    for (int slot = 0; slot < NET_MAX_CLIENTS; slot++) {
+        Client& client = clients[slot];
+        if (!client.connected) continue;
+
+        // One input per tick. When none came in time keep driving the same
+        // way, but a shot only counts once.
+        uint8_t packed = client.lastInput & ~PACKED_SHOT;
+        if (!client.inputs.empty()) {
+            packed = client.inputs.front().input;
+            client.usedInputSequence = client.inputs.front().sequence;
+            client.inputs.pop_front();
+        }
+        client.lastInput = packed;
+
+        SimInput input = UnpackInput(packed);
+        if (slot == 0) {
+            playerInput = input;
+        } else if (entities.IsAlive(client.tank)) {
+            entities.Velocities().Find(client.tank.index)->move = input.move;
+            entities.Weapons().Find(client.tank.index)->trigger = input.shoot;
+        }
+    }
+    return playerInput;
+}
+
+void MatchServer::CaptureWorld() {
+    PROFILE_ZONE("MatchServer::CaptureWorld");
+    const EntityStore& entities = level.GetEntities();
+    world.tick = tick;
+    world.match = match;
+    world.status = (uint8_t)level.GetStatus();
+    world.timeLeft = (uint32_t)std::lround(std::max(0.0f, level.GetTimeRemaining()) * 10.0f);
+    world.playerTank = level.GetPlayer().index;
+    world.tileCursor = (uint32_t)tileLog.size();
+
+    // Tanks are whatever has a transform, a collider and health
+    world.tanks.clear();
+    const ComponentArray<Collider>& colliders = entities.Colliders();
+    for (size_t i = 0; i < colliders.Size(); i++) {
+        uint32_t owner = colliders.Owner(i);
+        const Transform* transform = entities.Transforms().Find(owner);
+        const Health* health = entities.Healths().Find(owner);
+        if (!transform || !health) continue;
+
+        NetTank tank = {};
+        tank.id = owner;
+        tank.generation = entities.GetEntity(owner).generation;
+        tank.x = ToNetPosition(transform->position.x);
+        tank.y = ToNetPosition(transform->position.y);
+        tank.direction = PackInput({transform->direction, false});
+        tank.team = colliders[i].team;
+        tank.hitPoints = (uint8_t)std::clamp(health->hitPoints, 0, 255);
+        world.tanks.push_back(tank);
+    }
+    std::sort(world.tanks.begin(), world.tanks.end(),
+              [](const NetTank& a, const NetTank& b) { return a.id < b.id; });
+
+    world.bullets.clear();
+    const BulletPool& bullets = level.GetBullets();
+    for (size_t i = 0; i < bullets.Size(); i++) {
+        BulletHandle handle = bullets.GetHandle(i);
+        Vector2 position = bullets.GetPosition(i);
+        world.bullets.push_back({handle.slot, handle.generation, ToNetPosition(position.x),
+                                 ToNetPosition(position.y), bullets.GetTeam(i), (uint8_t)bullets.HasPowerUp(i)});
+    }
+    std::sort(world.bullets.begin(), world.bullets.end(),
+              [](const NetBullet& a, const NetBullet& b) { return a.id < b.id; });
+}
+
+void MatchServer::SendSnapshots() {
+    PROFILE_ZONE("MatchServer::SendSnapshots");
+    for (int slot = 0; slot < NET_MAX_CLIENTS; slot++) {
+        Client& client = clients[slot];
+        if (!client.connected) continue;
+
+        // Only what is around the client's tank, or around the player
+        // once its own tank is gone
+        bool hasTank = level.GetEntities().IsAlive(client.tank);
+        Vector2 focus = level.GetEntityPosition(hasTank ? client.tank : level.GetPlayer());
+        int32_t minX = ToNetPosition(focus.x - NET_VIEW_RANGE_X);
+        int32_t maxX = ToNetPosition(focus.x + NET_VIEW_RANGE_X);
+        int32_t minY = ToNetPosition(focus.y - NET_VIEW_RANGE_Y);
+        int32_t maxY = ToNetPosition(focus.y + NET_VIEW_RANGE_Y);
+
+        wanted.sequence = client.nextSequence++;
+        wanted.tick = world.tick;
+        wanted.match = world.match;
+        wanted.inputAck = client.usedInputSequence;
+        wanted.status = world.status;
+        wanted.timeLeft = world.timeLeft;
+        wanted.playerTank = world.playerTank;
+        wanted.ownTank = hasTank ? client.tank.index : UINT32_MAX;
+        wanted.tileCursor = world.tileCursor;
+        wanted.tanks.clear();
+        for (const NetTank& tank : world.tanks) {
+            if (tank.id == wanted.playerTank || tank.id == wanted.ownTank ||
+                (tank.x >= minX && tank.x <= maxX && tank.y >= minY && tank.y <= maxY)) {
+                wanted.tanks.push_back(tank);
+            }
+        }
+        wanted.bullets.clear();
+        for (const NetBullet& bullet : world.bullets) {
+            if (bullet.x >= minX && bullet.x <= maxX && bullet.y >= minY && bullet.y <= maxY) {
+                wanted.bullets.push_back(bullet);
+            }
+        }
+
+        // Against the newest snapshot it has, if that is still kept
+        const NetState* baseline = &none;
+        const NetState& acked = client.history[client.ackedSequence % NET_HISTORY];
+        if (client.ackedSequence != 0 && wanted.sequence - client.ackedSequence < NET_HISTORY &&
+            acked.sequence == client.ackedSequence) {
+            baseline = &acked;
+        } else {
+            fullSnapshotsSent++;
+        }
+
+        writer.Clear();
+        WriteSnapshot(writer, *baseline, wanted, tileLog, client.history[wanted.sequence % NET_HISTORY]);
+        Send(client.address);
+        snapshotsSent++;
+    }
+}
+
+uint16_t MatchServer::GetPort() const {
+    return socket.GetPort();
+}
+
+int MatchServer::GetClientCount() const {
+    return (int)std::count_if(clients.begin(), clients.end(), [](const Client& client) { return client.connected; });
+}
+
+uint32_t MatchServer::GetTick() const {
+    return tick;
+}
+
+const LevelManager& MatchServer::GetLevel() const {
+    return level;
+}
+
+size_t MatchServer::GetTileLogSize() const {
+    return tileLog.size();
+}
+
+uint64_t MatchServer::GetBytesSent() const {
+    return bytesSent;
+}
+
+uint64_t MatchServer::GetBytesReceived() const {
+    return bytesReceived;
+}
+
+uint32_t MatchServer::GetSnapshotsSent() const {
+    return snapshotsSent;
+}
+
+uint32_t MatchServer::GetFullSnapshotsSent() const {
+    return fullSnapshotsSent;
+}
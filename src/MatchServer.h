@@ -0,0 +1,109 @@
+#ifndef MATCHSERVER_H
+#define MATCHSERVER_H
+
+#include "LevelManager.h"
+#include "NetProtocol.h"
+#include "NetSocket.h"
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+// Seconds a finished match stays up before the level starts over
+const float MATCH_RESTART_DELAY = 3.0f;
+// Inputs a client can be ahead by, older ones are dropped to keep latency down
+const size_t MAX_QUEUED_INPUTS = 8;
+
+// Headless authoritative match over UDP: the only simulation runs here,
+// clients send input and get snapshots back (see NetProtocol.h). The
+// first client to join drives the level's player, whose death or escape
+// decides the match as in single player. Everyone after that gets a tank
+// of their own on the player's side at the spawn point. Tanks only move
+// inside the chunks resident around the level's player, so matches are
+// meant for levels about the size of the streaming window.
+class MatchServer {
+private:
+    struct QueuedInput {
+        uint32_t sequence;
+        uint8_t input;  // PackInput
+    };
+
+    struct Client {
+        bool connected;
+        NetAddress address;
+        Entity tank;
+        uint32_t lastHeard;          // tick
+        uint32_t nextSequence;       // of its snapshots, from 1
+        uint32_t ackedSequence;      // newest snapshot it has, 0 for none
+        uint32_t inputSequence;      // newest input received
+        uint32_t usedInputSequence;  // newest input applied
+        std::deque<QueuedInput> inputs;
+        uint8_t lastInput;           // held while no new input arrives
+        NetState history[NET_HISTORY];  // sent, by sequence % NET_HISTORY
+    };
+
+    LevelManager level;
+    std::string levelPath;
+    NetSocket socket;
+    std::vector<Client> clients;  // NET_MAX_CLIENTS, the index is the slot
+    // Every tile change of this match, in order. Never shrinks until the
+    // restart, so a snapshot only needs a position in it.
+    std::vector<uint32_t> tileLog;
+    uint32_t tick;
+    uint32_t match;
+    int restartTicks;  // counted down once the match is over
+    Vector2 spawnPosition;
+    NetState none;     // baseline for clients without a recent ack
+    NetState world;    // everything, captured once per snapshot tick
+    NetState wanted;   // world as one client gets to see it
+    NetWriter writer;
+    unsigned char receiveBuffer[2048];
+
+    uint64_t bytesSent;
+    uint64_t bytesReceived;
+    uint32_t snapshotsSent;
+    uint32_t fullSnapshotsSent;
+
+    void ReceiveMessages();
+    void HandleHello(const NetAddress& from, NetReader& in);
+    void HandleInput(Client& client, NetReader& in);
+    void SendWelcome(int slot);
+    void SendReject(const NetAddress& to, NetRejectReason reason);
+    void Send(const NetAddress& to);
+    void Disconnect(int slot);
+    void SpawnClientTank(int slot);
+    void Restart();
+    SimInput ApplyInputs();
+    void CaptureWorld();
+    void SendSnapshots();
+
+public:
+    MatchServer();
+    ~MatchServer();
+    MatchServer(const MatchServer&) = delete;
+    MatchServer& operator=(const MatchServer&) = delete;
+
+    // Loads the level and listens on port, 0 picks a free one. Clients
+    // open the level by the same path, so give it relative to the game's
+    // folder.
+    bool Start(const std::string& levelPath, uint16_t port, std::string& error);
+    // Tells the clients and closes the socket
+    void Stop();
+    // Reads what the clients sent, advances the level by SIM_TIMESTEP
+    // while anyone is connected and sends snapshots every
+    // NET_SNAPSHOT_INTERVAL ticks. Call it at the simulation rate.
+    void Tick();
+
+    uint16_t GetPort() const;
+    int GetClientCount() const;
+    uint32_t GetTick() const;
+    const LevelManager& GetLevel() const;
+    size_t GetTileLogSize() const;
+    uint64_t GetBytesSent() const;
+    uint64_t GetBytesReceived() const;
+    uint32_t GetSnapshotsSent() const;
+    // Snapshots sent against no baseline
+    uint32_t GetFullSnapshotsSent() const;
+};
+
+#endif
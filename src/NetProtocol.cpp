@@ -0,0 +1,401 @@
+#include "NetProtocol.h"
+
+// Snapshot records: a tank or bullet starts with its id as the gap to the
+// previous id plus one (0 ends the list), then a mask of what follows
+const uint8_t ITEM_NEW = 1 << 0;         // everything, no baseline needed
+const uint8_t ITEM_POSITION = 1 << 1;    // x and y moved by
+const uint8_t ITEM_DIRECTION = 1 << 2;   // tanks only
+const uint8_t ITEM_HIT_POINTS = 1 << 3;  // tanks only
+
+// Room left at the end of a snapshot for the list ends and the tile header
+const size_t SNAPSHOT_RESERVE = 16;
+
+void ResetNetState(NetState& state) {
+    state.sequence = 0;
+    state.tick = 0;
+    state.match = 0;
+    state.inputAck = 0;
+    state.status = 0;
+    state.timeLeft = 0;
+    state.playerTank = UINT32_MAX;
+    state.ownTank = UINT32_MAX;
+    state.tileCursor = 0;
+    state.tanks.clear();
+    state.bullets.clear();
+}
+
+void NetWriter::Clear() {
+    bytes.clear();
+}
+
+void NetWriter::U8(uint8_t value) {
+    bytes.push_back(value);
+}
+
+void NetWriter::U16(uint16_t value) {
+    bytes.push_back((unsigned char)(value & 0xff));
+    bytes.push_back((unsigned char)(value >> 8));
+}
+
+void NetWriter::VarUint(uint32_t value) {
+    while (value >= 0x80) {
+        bytes.push_back((unsigned char)(value | 0x80));
+        value >>= 7;
+    }
+    bytes.push_back((unsigned char)value);
+}
+
+void NetWriter::VarInt(int32_t value) {
+    VarUint(((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+}
+
+void NetWriter::String(const std::string& value) {
+    VarUint((uint32_t)value.size());
+    bytes.insert(bytes.end(), value.begin(), value.end());
+}
+
+void NetWriter::Truncate(size_t size) {
+    if (size < bytes.size()) {
+        bytes.resize(size);
+    }
+}
+
+size_t NetWriter::Size() const {
+    return bytes.size();
+}
+
+const unsigned char* NetWriter::Data() const {
+    return bytes.data();
+}
+
+NetReader::NetReader(const unsigned char* bytes, size_t length) : data(bytes), size(length), offset(0), failed(false) {}
+
+uint8_t NetReader::U8() {
+    if (offset >= size) {
+        failed = true;
+        return 0;
+    }
+    return data[offset++];
+}
+
+uint16_t NetReader::U16() {
+    uint16_t low = U8();
+    return (uint16_t)(low | U8() << 8);
+}
+
+uint32_t NetReader::VarUint() {
+    uint32_t value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        uint8_t byte = U8();
+        value |= (uint32_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+    failed = true;
+    return 0;
+}
+
+int32_t NetReader::VarInt() {
+    uint32_t value = VarUint();
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+std::string NetReader::String() {
+    uint32_t length = VarUint();
+    if (length > size - offset) {
+        failed = true;
+        return std::string();
+    }
+    std::string value(reinterpret_cast<const char*>(data + offset), length);
+    offset += length;
+    return value;
+}
+
+bool NetReader::Failed() const {
+    return failed;
+}
+
+bool NetReader::AtEnd() const {
+    return offset == size;
+}
+
+static size_t VarUintSize(uint32_t value) {
+    size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+static uint8_t ChangeMask(const NetTank& base, const NetTank& tank) {
+    if (base.generation != tank.generation) return ITEM_NEW;
+    uint8_t mask = 0;
+    if (base.x != tank.x || base.y != tank.y) mask |= ITEM_POSITION;
+    if (base.direction != tank.direction) mask |= ITEM_DIRECTION;
+    if (base.hitPoints != tank.hitPoints) mask |= ITEM_HIT_POINTS;
+    return mask;
+}
+
+static uint8_t ChangeMask(const NetBullet& base, const NetBullet& bullet) {
+    if (base.generation != bullet.generation) return ITEM_NEW;
+    return base.x != bullet.x || base.y != bullet.y ? ITEM_POSITION : 0;
+}
+
+static void WriteFields(NetWriter& out, const NetTank* base, const NetTank& tank, uint8_t mask) {
+    if (mask & ITEM_NEW) {
+        out.VarUint(tank.generation);
+        out.VarInt(tank.x);
+        out.VarInt(tank.y);
+        out.U8(tank.direction);
+        out.U8(tank.team);
+        out.U8(tank.hitPoints);
+        return;
+    }
+    if (mask & ITEM_POSITION) {
+        out.VarInt(tank.x - base->x);
+        out.VarInt(tank.y - base->y);
+    }
+    if (mask & ITEM_DIRECTION) out.U8(tank.direction);
+    if (mask & ITEM_HIT_POINTS) out.U8(tank.hitPoints);
+}
+
+static void WriteFields(NetWriter& out, const NetBullet* base, const NetBullet& bullet, uint8_t mask) {
+    if (mask & ITEM_NEW) {
+        out.VarUint(bullet.generation);
+        out.VarInt(bullet.x);
+        out.VarInt(bullet.y);
+        out.U8((uint8_t)(bullet.team | bullet.powerUp << 7));
+        return;
+    }
+    out.VarInt(bullet.x - base->x);
+    out.VarInt(bullet.y - base->y);
+}
+
+static void ReadFields(NetReader& in, const NetTank* base, NetTank& tank, uint8_t mask) {
+    if (mask & ITEM_NEW) {
+        tank.generation = in.VarUint();
+        tank.x = in.VarInt();
+        tank.y = in.VarInt();
+        tank.direction = in.U8();
+        tank.team = in.U8();
+        tank.hitPoints = in.U8();
+        return;
+    }
+    uint32_t id = tank.id;
+    tank = *base;
+    tank.id = id;
+    if (mask & ITEM_POSITION) {
+        tank.x += in.VarInt();
+        tank.y += in.VarInt();
+    }
+    if (mask & ITEM_DIRECTION) tank.direction = in.U8();
+    if (mask & ITEM_HIT_POINTS) tank.hitPoints = in.U8();
+}
+
+static void ReadFields(NetReader& in, const NetBullet* base, NetBullet& bullet, uint8_t mask) {
+    if (mask & ITEM_NEW) {
+        bullet.generation = in.VarUint();
+        bullet.x = in.VarInt();
+        bullet.y = in.VarInt();
+        uint8_t packed = in.U8();
+        bullet.team = packed & 0x7f;
+        bullet.powerUp = packed >> 7;
+        return;
+    }
+    uint32_t id = bullet.id;
+    bullet = *base;
+    bullet.id = id;
+    if (mask & ITEM_POSITION) {
+        bullet.x += in.VarInt();
+        bullet.y += in.VarInt();
+    }
+}
+
+// Both lists sorted by id. Removals and changes that would go past limit
+// are held back, so sent keeps the baseline's version of those items.
+template <typename T>
+static void WriteItems(NetWriter& out, const std::vector<T>& baseline, const std::vector<T>& items,
+                       size_t limit, std::vector<T>& sent) {
+    // Removed: in the baseline but not in items. Those from removedUpTo on
+    // didn't fit and stay on the client for now.
+    uint32_t removedUpTo = UINT32_MAX;
+    uint32_t next = 0;
+    size_t j = 0;
+    for (const T& base : baseline) {
+        while (j < items.size() && items[j].id < base.id) j++;
+        if (j < items.size() && items[j].id == base.id) continue;
+
+        size_t before = out.Size();
+        out.VarUint(base.id - next + 1);
+        if (out.Size() > limit) {
+            out.Truncate(before);
+            removedUpTo = base.id;
+            break;
+        }
+        next = base.id + 1;
+    }
+    out.VarUint(0);
+
+    // Changed and new, merged with the baseline to keep sent in id order
+    sent.clear();
+    next = 0;
+    size_t i = 0;
+    j = 0;
+    while (i < baseline.size() || j < items.size()) {
+        if (j == items.size() || (i < baseline.size() && baseline[i].id < items[j].id)) {
+            if (baseline[i].id >= removedUpTo) {
+                sent.push_back(baseline[i]);
+            }
+            i++;
+            continue;
+        }
+
+        const T& item = items[j++];
+        const T* base = nullptr;
+        if (i < baseline.size() && baseline[i].id == item.id) {
+            base = &baseline[i++];
+        }
+        uint8_t mask = base ? ChangeMask(*base, item) : ITEM_NEW;
+        if (mask == 0) {
+            sent.push_back(item);
+            continue;
+        }
+
+        size_t before = out.Size();
+        out.VarUint(item.id - next + 1);
+        out.U8(mask);
+        WriteFields(out, base, item, mask);
+        if (out.Size() > limit) {
+            out.Truncate(before);
+            if (base) {
+                sent.push_back(*base);
+            }
+            continue;
+        }
+        next = item.id + 1;
+        sent.push_back(item);
+    }
+    out.VarUint(0);
+}
+
+template <typename T>
+static bool ReadItems(NetReader& in, const std::vector<T>& baseline, std::vector<T>& items) {
+    std::vector<uint32_t> removed;
+    uint32_t next = 0;
+    for (uint32_t gap = in.VarUint(); gap != 0 && !in.Failed(); gap = in.VarUint()) {
+        next += gap - 1;
+        removed.push_back(next++);
+    }
+
+    // Baseline items up to each record carry over unless removed
+    items.clear();
+    size_t i = 0;
+    size_t r = 0;
+    auto carryUntil = [&](uint32_t id) {
+        for (; i < baseline.size() && baseline[i].id < id; i++) {
+            while (r < removed.size() && removed[r] < baseline[i].id) r++;
+            if (r < removed.size() && removed[r] == baseline[i].id) continue;
+            items.push_back(baseline[i]);
+        }
+    };
+
+    next = 0;
+    for (uint32_t gap = in.VarUint(); gap != 0 && !in.Failed(); gap = in.VarUint()) {
+        T item = {};
+        item.id = next + gap - 1;
+        next = item.id + 1;
+        carryUntil(item.id);
+
+        const T* base = i < baseline.size() && baseline[i].id == item.id ? &baseline[i++] : nullptr;
+        uint8_t mask = in.U8();
+        if (!base && !(mask & ITEM_NEW)) return false;
+        ReadFields(in, base, item, mask);
+        items.push_back(item);
+    }
+    carryUntil(UINT32_MAX);
+    return !in.Failed();
+}
+
+void WriteSnapshot(NetWriter& out, const NetState& baseline, const NetState& state,
+                   const std::vector<uint32_t>& tileLog, NetState& sent) {
+    out.U8((uint8_t)NetMessage::SNAPSHOT);
+    out.VarUint(state.sequence);
+    out.VarUint(baseline.sequence);
+    out.VarUint(state.tick);
+    out.VarUint(state.match);
+    out.VarUint(state.inputAck);
+    out.U8(state.status);
+    out.VarUint(state.timeLeft);
+    out.VarUint(state.playerTank + 1);  // UINT32_MAX goes out as 0
+    out.VarUint(state.ownTank + 1);
+
+    sent.sequence = state.sequence;
+    sent.tick = state.tick;
+    sent.match = state.match;
+    sent.inputAck = state.inputAck;
+    sent.status = state.status;
+    sent.timeLeft = state.timeLeft;
+    sent.playerTank = state.playerTank;
+    sent.ownTank = state.ownTank;
+
+    // Tanks first, they matter most when a lot happens at once
+    size_t limit = NET_MAX_PACKET - SNAPSHOT_RESERVE;
+    WriteItems(out, baseline.tanks, state.tanks, limit, sent.tanks);
+    WriteItems(out, baseline.bullets, state.bullets, limit, sent.bullets);
+
+    // As many new log entries as still fit, a client that joins late
+    // catches up over a few snapshots
+    uint32_t start = baseline.tileCursor;
+    uint32_t count = 0;
+    size_t size = out.Size() + VarUintSize(start) + VarUintSize(state.tileCursor - start);
+    while (start + count < state.tileCursor && size + VarUintSize(tileLog[start + count]) <= NET_MAX_PACKET) {
+        size += VarUintSize(tileLog[start + count]);
+        count++;
+    }
+    out.VarUint(start);
+    out.VarUint(count);
+    for (uint32_t k = 0; k < count; k++) {
+        out.VarUint(tileLog[start + k]);
+    }
+    sent.tileCursor = start + count;
+}
+
+bool ReadSnapshot(NetReader& in, const NetState* history, std::vector<uint32_t>& tileLog, NetState& state) {
+    static const NetState none = {0, 0, 0, 0, 0, 0, UINT32_MAX, UINT32_MAX, 0, {}, {}};
+
+    state.sequence = in.VarUint();
+    uint32_t baselineSequence = in.VarUint();
+    const NetState* baseline = &none;
+    if (baselineSequence != 0) {
+        baseline = &history[baselineSequence % NET_HISTORY];
+        if (baseline->sequence != baselineSequence) return false;
+    }
+    if (in.Failed() || state.sequence <= baselineSequence) return false;
+
+    state.tick = in.VarUint();
+    state.match = in.VarUint();
+    state.inputAck = in.VarUint();
+    state.status = in.U8();
+    state.timeLeft = in.VarUint();
+    state.playerTank = in.VarUint() - 1;
+    state.ownTank = in.VarUint() - 1;
+    if (!ReadItems(in, baseline->tanks, state.tanks) || !ReadItems(in, baseline->bullets, state.bullets)) {
+        return false;
+    }
+
+    uint32_t start = in.VarUint();
+    uint32_t count = in.VarUint();
+    if (in.Failed() || start != baseline->tileCursor || start > tileLog.size() || count > NET_MAX_PACKET) {
+        return false;
+    }
+    uint32_t entries[NET_MAX_PACKET];
+    for (uint32_t k = 0; k < count; k++) {
+        entries[k] = in.VarUint();
+    }
+    if (in.Failed() || !in.AtEnd()) return false;
+
+    tileLog.resize(start);
+    tileLog.insert(tileLog.end(), entries, entries + count);
+    state.tileCursor = start + count;
+    return true;
+}
@@ -0,0 +1,160 @@
+#ifndef NETPROTOCOL_H
+#define NETPROTOCOL_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Match server protocol, one UDP datagram per message. Every message
+// starts with a NetMessage byte; numbers are LEB128 varints unless noted,
+// signed ones zigzag encoded first.
+//
+// Clients send their input every tick, the server sends a snapshot every
+// NET_SNAPSHOT_INTERVAL ticks encoded against the newest snapshot the
+// client acknowledged: tanks and bullets that didn't change are left out,
+// moved ones only say how far they moved. Tiles only ever change a few at
+// a time, so the server keeps them as an append-only log of changes and a
+// snapshot carries the log entries past the ones in its baseline. A
+// client without a recent acknowledged snapshot gets one against nothing.
+const uint16_t NET_PROTOCOL_VERSION = 1;
+const uint16_t NET_DEFAULT_PORT = 47800;
+const int NET_MAX_CLIENTS = 8;
+const int NET_SNAPSHOT_INTERVAL = 4;    // ticks, 30 snapshots a second
+const size_t NET_MAX_PACKET = 1200;     // stays under the usual MTU
+const int NET_HISTORY = 32;             // snapshots kept as baselines, a second
+const int NET_INPUT_REDUNDANCY = 8;     // every input message repeats this many
+const int NET_POSITION_SCALE = 8;       // positions go out in 1/8 pixels
+const float NET_TIMEOUT = 5.0f;         // seconds without a message
+// Tanks and bullets this far from a client's tank (in pixels, per axis)
+// are left out of its snapshots, the level's player and its own tank
+// never are
+const float NET_VIEW_RANGE_X = 640.0f;
+const float NET_VIEW_RANGE_Y = 480.0f;
+
+enum class NetMessage : uint8_t {
+    HELLO,       // client: u16 protocol version
+    WELCOME,     // server: slot, bullet capacity, level path
+    REJECT,      // server: NetRejectReason byte
+    INPUT,       // client: acked snapshot, newest input sequence, inputs
+    SNAPSHOT,    // server: see WriteSnapshot
+    DISCONNECT   // either side, nothing else
+};
+
+enum class NetRejectReason : uint8_t {
+    FULL,
+    VERSION
+};
+
+struct NetTank {
+    uint32_t id;          // entity index on the server
+    uint32_t generation;
+    int32_t x;            // NET_POSITION_SCALE units
+    int32_t y;
+    uint8_t direction;    // PackInput of the facing
+    uint8_t team;
+    uint8_t hitPoints;
+};
+
+struct NetBullet {
+    uint32_t id;          // pool slot on the server
+    uint32_t generation;
+    int32_t x;
+    int32_t y;
+    uint8_t team;
+    uint8_t powerUp;
+};
+
+// What a client knows after one snapshot. Tanks and bullets are sorted by
+// id, tileCursor is how many entries of the tile log it covers.
+struct NetState {
+    uint32_t sequence;    // per client, from 1, 0 is no snapshot
+    uint32_t tick;
+    uint32_t match;       // goes up whenever the server restarts the level
+    uint32_t inputAck;    // newest input of this client the server used
+    uint8_t status;       // LevelStatus
+    uint32_t timeLeft;    // tenths of a second
+    uint32_t playerTank;  // id of the level's player
+    uint32_t ownTank;     // id of the client's tank, UINT32_MAX if it has none
+    uint32_t tileCursor;
+    std::vector<NetTank> tanks;
+    std::vector<NetBullet> bullets;
+};
+
+// Clears the state to "no snapshot", keeping the buffers
+void ResetNetState(NetState& state);
+
+inline int32_t ToNetPosition(float value) {
+    return (int32_t)std::lround(value * NET_POSITION_SCALE);
+}
+
+inline float FromNetPosition(int32_t value) {
+    return (float)value / NET_POSITION_SCALE;
+}
+
+// Tile log entries, flags are TILE_DESTROYED and TILE_ANIMATING
+inline uint32_t PackTileChange(int index, uint8_t flags) {
+    return (uint32_t)index << 2 | (flags & 3);
+}
+
+inline int TileChangeIndex(uint32_t entry) {
+    return (int)(entry >> 2);
+}
+
+inline uint8_t TileChangeFlags(uint32_t entry) {
+    return (uint8_t)(entry & 3);
+}
+
+class NetWriter {
+private:
+    std::vector<unsigned char> bytes;
+
+public:
+    void Clear();
+    void U8(uint8_t value);
+    void U16(uint16_t value);  // little-endian
+    void VarUint(uint32_t value);
+    void VarInt(int32_t value);
+    void String(const std::string& value);
+    // Drops everything written after size, to take back what didn't fit
+    void Truncate(size_t size);
+    size_t Size() const;
+    const unsigned char* Data() const;
+};
+
+// Reads past the end, or a malformed varint, return 0 and mark the reader
+// failed, so a message can be read through and checked once at the end
+class NetReader {
+private:
+    const unsigned char* data;
+    size_t size;
+    size_t offset;
+    bool failed;
+
+public:
+    NetReader(const unsigned char* data, size_t size);
+    uint8_t U8();
+    uint16_t U16();
+    uint32_t VarUint();
+    int32_t VarInt();
+    std::string String();
+    bool Failed() const;
+    bool AtEnd() const;
+};
+
+// Writes a SNAPSHOT message of state against baseline (a state with
+// sequence 0 for none). Changes that don't fit in NET_MAX_PACKET wait for a
+// later snapshot; sent is set to what the client has after this one, which
+// is the baseline for that later snapshot. state's tile cursor must not be
+// past the end of tileLog.
+void WriteSnapshot(NetWriter& out, const NetState& baseline, const NetState& state,
+                   const std::vector<uint32_t>& tileLog, NetState& sent);
+// Reads a SNAPSHOT message after its type byte. history holds the
+// client's NET_HISTORY newest snapshots by sequence % NET_HISTORY, the
+// baseline has to be among them. Tile entries in the message replace
+// tileLog from the baseline's cursor on. False, with state undefined, if
+// the message is malformed or its baseline is gone.
+bool ReadSnapshot(NetReader& in, const NetState* history, std::vector<uint32_t>& tileLog, NetState& state);
+
+#endif
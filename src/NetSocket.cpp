@@ -0,0 +1,183 @@
+#include "NetSocket.h"
+#include <cstdlib>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef int socklen_t;
+typedef SOCKET NativeSocket;
+#else
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int NativeSocket;
+#endif
+
+static bool StartSockets() {
+#ifdef _WIN32
+    // Once per process, Windows tears it down on exit
+    static bool started = false;
+    if (!started) {
+        WSADATA data;
+        started = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }
+    return started;
+#else
+    return true;
+#endif
+}
+
+static sockaddr_in ToSockaddr(const NetAddress& address) {
+    sockaddr_in result = {};
+    result.sin_family = AF_INET;
+    result.sin_addr.s_addr = htonl(address.ip);
+    result.sin_port = htons(address.port);
+    return result;
+}
+
+bool ParseAddress(const std::string& text, uint16_t defaultPort, NetAddress& address, std::string& error) {
+    std::string host = text;
+    uint16_t port = defaultPort;
+    size_t colon = text.rfind(':');
+    if (colon != std::string::npos) {
+        host = text.substr(0, colon);
+        unsigned long value = std::strtoul(text.c_str() + colon + 1, nullptr, 10);
+        if (value == 0 || value > 65535) {
+            error = "bad port in " + text;
+            return false;
+        }
+        port = (uint16_t)value;
+    }
+    if (host.empty()) {
+        error = "no host in " + text;
+        return false;
+    }
+    if (!StartSockets()) {
+        error = "cannot start sockets";
+        return false;
+    }
+
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* found = nullptr;
+    if (getaddrinfo(host.c_str(), nullptr, &hints, &found) != 0 || !found) {
+        error = "cannot resolve " + host;
+        return false;
+    }
+    address.ip = ntohl(reinterpret_cast<sockaddr_in*>(found->ai_addr)->sin_addr.s_addr);
+    address.port = port;
+    freeaddrinfo(found);
+    return true;
+}
+
+std::string FormatAddress(const NetAddress& address) {
+    return std::to_string(address.ip >> 24) + "." + std::to_string((address.ip >> 16) & 255) + "." +
+           std::to_string((address.ip >> 8) & 255) + "." + std::to_string(address.ip & 255) + ":" +
+           std::to_string(address.port);
+}
+
+NetSocket::NetSocket() : handle(-1), port(0) {}
+
+NetSocket::~NetSocket() {
+    Close();
+}
+
+bool NetSocket::Open(uint16_t localPort, std::string& error) {
+    Close();
+    if (!StartSockets()) {
+        error = "cannot start sockets";
+        return false;
+    }
+
+#ifdef _WIN32
+    SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s == INVALID_SOCKET) {
+        error = "cannot create socket";
+        return false;
+    }
+    u_long nonBlocking = 1;
+    bool configured = ioctlsocket(s, FIONBIO, &nonBlocking) == 0;
+#else
+    int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s < 0) {
+        error = "cannot create socket";
+        return false;
+    }
+    bool configured = fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK) == 0;
+#endif
+    handle = (intptr_t)s;
+
+    sockaddr_in local = ToSockaddr({INADDR_ANY, localPort});
+    if (!configured || bind(s, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0) {
+        error = "cannot bind port " + std::to_string(localPort);
+        Close();
+        return false;
+    }
+
+    socklen_t length = sizeof(local);
+    getsockname(s, reinterpret_cast<sockaddr*>(&local), &length);
+    port = ntohs(local.sin_port);
+    return true;
+}
+
+void NetSocket::Close() {
+    if (handle < 0) return;
+#ifdef _WIN32
+    closesocket((NativeSocket)handle);
+#else
+    close((NativeSocket)handle);
+#endif
+    handle = -1;
+    port = 0;
+}
+
+bool NetSocket::IsOpen() const {
+    return handle >= 0;
+}
+
+uint16_t NetSocket::GetPort() const {
+    return port;
+}
+
+bool NetSocket::Send(const NetAddress& to, const void* data, size_t size) {
+    if (handle < 0) return false;
+    sockaddr_in address = ToSockaddr(to);
+    return sendto((NativeSocket)handle, static_cast<const char*>(data), (int)size, 0,
+                  reinterpret_cast<sockaddr*>(&address), sizeof(address)) == (int)size;
+}
+
+size_t NetSocket::Receive(NetAddress& from, void* buffer, size_t capacity) {
+    if (handle < 0) return 0;
+    for (;;) {
+        sockaddr_in address = {};
+        socklen_t length = sizeof(address);
+        int received = recvfrom((NativeSocket)handle, static_cast<char*>(buffer), (int)capacity, 0,
+                                reinterpret_cast<sockaddr*>(&address), &length);
+        if (received > 0) {
+            from = {ntohl(address.sin_addr.s_addr), ntohs(address.sin_port)};
+            return (size_t)received;
+        }
+#ifdef _WIN32
+        // A datagram too long for the buffer still arrives, cut off. An
+        // earlier send to a closed port shows up as a reset, skip it.
+        int code = WSAGetLastError();
+        if (received < 0 && code == WSAEMSGSIZE) {
+            from = {ntohl(address.sin_addr.s_addr), ntohs(address.sin_port)};
+            return capacity;
+        }
+        if (received < 0 && code == WSAECONNRESET) continue;
+#else
+        if (received < 0 && errno == EINTR) continue;
+#endif
+        // Nothing waiting, or an empty datagram, which no message is
+        if (received == 0) continue;
+        return 0;
+    }
+}
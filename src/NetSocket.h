@@ -0,0 +1,53 @@
+#ifndef NETSOCKET_H
+#define NETSOCKET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// IPv4 address and port, both in host byte order
+struct NetAddress {
+    uint32_t ip;
+    uint16_t port;
+};
+
+inline bool operator==(const NetAddress& a, const NetAddress& b) {
+    return a.ip == b.ip && a.port == b.port;
+}
+
+inline bool operator!=(const NetAddress& a, const NetAddress& b) {
+    return !(a == b);
+}
+
+// "host:port", or just "host" for defaultPort. The host can be a name or
+// a dotted quad, names are looked up (blocking).
+bool ParseAddress(const std::string& text, uint16_t defaultPort, NetAddress& address, std::string& error);
+std::string FormatAddress(const NetAddress& address);
+
+// Non-blocking UDP socket bound to every interface, so it answers on
+// loopback and on the LAN alike
+class NetSocket {
+private:
+    intptr_t handle;  // -1 while closed
+    uint16_t port;
+
+public:
+    NetSocket();
+    ~NetSocket();
+    NetSocket(const NetSocket&) = delete;
+    NetSocket& operator=(const NetSocket&) = delete;
+
+    // Port 0 picks a free one, GetPort tells which
+    bool Open(uint16_t port, std::string& error);
+    void Close();
+    bool IsOpen() const;
+    uint16_t GetPort() const;
+
+    // UDP may drop it anyway, false only if the system refused it
+    bool Send(const NetAddress& to, const void* data, size_t size);
+    // Size of the next waiting datagram, 0 when there is none. Longer
+    // datagrams than capacity are cut off.
+    size_t Receive(NetAddress& from, void* buffer, size_t capacity);
+};
+
+#endif
@@ -0,0 +1,210 @@
+#include "Profiler.h"
+#include "raylib.h"
+#include <algorithm>
+#include <fstream>
+
+Profiler* Profiler::instance = nullptr;
+std::atomic<bool> Profiler::enabled(false);
+
+static std::atomic<uint32_t> nextThreadId(0);
+static thread_local uint32_t threadId = UINT32_MAX;
+static thread_local uint32_t zoneDepth = 0;
+
+Profiler* Profiler::GetInstance() {
+    if (!instance) {
+        instance = new Profiler();
+    }
+    return instance;
+}
+
+void Profiler::DestroyInstance() {
+    if (instance) {
+        enabled.store(false, std::memory_order_relaxed);
+        delete instance;
+        instance = nullptr;
+    }
+}
+
+Profiler::Profiler() : slots(new Slot[PROFILE_CAPACITY]), head(0),
+                       epoch(std::chrono::steady_clock::now()), frameTimes{}, frameStarts{},
+                       frameCount(0), lastFrame(0) {
+    for (size_t i = 0; i < PROFILE_CAPACITY; i++) {
+        slots[i].sequence.store(0, std::memory_order_relaxed);
+    }
+}
+
+void Profiler::SetEnabled(bool value) {
+    enabled.store(value, std::memory_order_relaxed);
+    lastFrame = Now();
+}
+
+uint64_t Profiler::Now() const {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Profiler::Record(const char* name, uint64_t start, uint64_t end, uint32_t depth) {
+    if (threadId == UINT32_MAX) {
+        threadId = nextThreadId.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Claim the next slot, mark it as being written, fill it, then publish
+    // it with its position so readers can spot torn or stale entries
+    uint64_t index = head.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = slots[index % PROFILE_CAPACITY];
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.start.store(start, std::memory_order_relaxed);
+    slot.duration.store(end - start, std::memory_order_relaxed);
+    slot.thread.store(threadId, std::memory_order_relaxed);
+    slot.depth.store(depth, std::memory_order_relaxed);
+    slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::MarkFrame() {
+    if (!IsEnabled()) return;
+
+    uint64_t now = Now();
+    int frame = (int)(frameCount % PROFILE_FRAMES);
+    frameTimes[frame] = (now - lastFrame) / 1e6f;
+    frameStarts[frame] = lastFrame;
+    frameCount++;
+    lastFrame = now;
+}
+
+std::vector<ProfileEvent> Profiler::GetEvents() const {
+    std::vector<ProfileEvent> events;
+    uint64_t end = head.load(std::memory_order_acquire);
+    uint64_t begin = end > PROFILE_CAPACITY ? end - PROFILE_CAPACITY : 0;
+    events.reserve((size_t)(end - begin));
+
+    for (uint64_t index = begin; index < end; index++) {
+        const Slot& slot = slots[index % PROFILE_CAPACITY];
+        if (slot.sequence.load(std::memory_order_acquire) != index + 1) continue;
+        ProfileEvent event = {slot.name.load(std::memory_order_relaxed),
+                              slot.start.load(std::memory_order_relaxed),
+                              slot.duration.load(std::memory_order_relaxed),
+                              slot.thread.load(std::memory_order_relaxed),
+                              slot.depth.load(std::memory_order_relaxed)};
+        std::atomic_thread_fence(std::memory_order_acquire);
+        // Overwritten while we copied it
+        if (slot.sequence.load(std::memory_order_relaxed) != index + 1) continue;
+        events.push_back(event);
+    }
+    return events;
+}
+
+std::vector<ZoneStats> Profiler::GetZoneStats(int frames) const {
+    std::vector<ZoneStats> stats;
+    frames = (int)std::min<uint64_t>((uint64_t)std::min(frames, PROFILE_FRAMES), frameCount);
+    if (frames <= 0) return stats;
+
+    uint64_t windowStart = frameStarts[(frameCount - frames) % PROFILE_FRAMES];
+    uint64_t windowEnd = lastFrame;
+    for (const ProfileEvent& event : GetEvents()) {
+        if (event.start < windowStart || event.start >= windowEnd) continue;
+
+        auto it = std::find_if(stats.begin(), stats.end(),
+                               [&event](const ZoneStats& zone) { return zone.name == event.name; });
+        if (it == stats.end()) {
+            stats.push_back({event.name, 0, 0, 0});
+            it = stats.end() - 1;
+        }
+        double ms = event.duration / 1e6;
+        it->calls++;
+        it->totalMs += ms;
+        it->maxMs = std::max(it->maxMs, ms);
+    }
+
+    // Per frame averages
+    for (ZoneStats& zone : stats) {
+        zone.totalMs /= frames;
+    }
+    std::sort(stats.begin(), stats.end(),
+              [](const ZoneStats& a, const ZoneStats& b) { return a.totalMs > b.totalMs; });
+    return stats;
+}
+
+bool Profiler::ExportCsv(const std::string& path, std::string& error) const {
+    std::ofstream out(path);
+    if (!out) {
+        error = "cannot write " + path;
+        return false;
+    }
+
+    out << "thread,depth,zone,start_us,duration_us\n";
+    for (const ProfileEvent& event : GetEvents()) {
+        out << event.thread << "," << event.depth << "," << event.name << ","
+            << event.start / 1000.0 << "," << event.duration / 1000.0 << "\n";
+    }
+    return true;
+}
+
+bool Profiler::ExportChromeTrace(const std::string& path, std::string& error) const {
+    std::ofstream out(path);
+    if (!out) {
+        error = "cannot write " + path;
+        return false;
+    }
+
+    // Complete ("X") events, the viewer nests them by time on each thread
+    out << "{\"traceEvents\":[\n";
+    bool first = true;
+    for (const ProfileEvent& event : GetEvents()) {
+        if (!first) out << ",\n";
+        first = false;
+        out << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+            << ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << event.duration / 1000.0 << "}";
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return true;
+}
+
+void Profiler::DrawOverlay(int x, int y) const {
+    const int width = 360;
+    const int graphHeight = 80;
+    std::vector<ZoneStats> zones = GetZoneStats(120);
+    int height = graphHeight + 50 + (int)zones.size() * 16;
+
+    DrawRectangle(x, y, width, height, Fade(BLACK, 0.75f));
+
+    // One bar per frame, newest on the right. The line is 60 fps.
+    const float msPerPixel = 33.3f / graphHeight;
+    int frames = (int)std::min<uint64_t>(frameCount, PROFILE_FRAMES);
+    float barWidth = (float)(width - 20) / PROFILE_FRAMES;
+    for (int i = 0; i < frames; i++) {
+        float ms = frameTimes[(frameCount - frames + i) % PROFILE_FRAMES];
+        float barHeight = std::min(ms / msPerPixel, (float)graphHeight);
+        Color color = ms > 16.7f ? RED : GREEN;
+        DrawRectangleRec({x + 10 + (PROFILE_FRAMES - frames + i) * barWidth, y + 10 + graphHeight - barHeight,
+                          std::max(barWidth, 1.0f), barHeight}, color);
+    }
+    int budgetY = y + 10 + graphHeight - (int)(16.7f / msPerPixel);
+    DrawLine(x + 10, budgetY, x + width - 10, budgetY, YELLOW);
+
+    float lastMs = frames > 0 ? frameTimes[(frameCount - 1) % PROFILE_FRAMES] : 0.0f;
+    int rowY = y + graphHeight + 16;
+    DrawText(TextFormat("frame %.2f ms   zone  ms/frame  max  calls", lastMs), x + 10, rowY, 10, WHITE);
+    for (const ZoneStats& zone : zones) {
+        rowY += 16;
+        DrawText(zone.name, x + 10, rowY, 10, LIGHTGRAY);
+        DrawText(TextFormat("%7.3f %7.3f %5d", zone.totalMs, zone.maxMs, zone.calls), x + 200, rowY, 10, LIGHTGRAY);
+    }
+}
+
+ProfileZone::ProfileZone(const char* zoneName) : name(zoneName), start(0), active(false) {
+    if (!Profiler::IsEnabled()) return;
+
+    active = true;
+    zoneDepth++;
+    start = Profiler::GetInstance()->Now();
+}
+
+ProfileZone::~ProfileZone() {
+    if (!active) return;
+
+    zoneDepth--;
+    Profiler* profiler = Profiler::GetInstance();
+    profiler->Record(name, start, profiler->Now(), zoneDepth);
+}
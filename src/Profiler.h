@@ -0,0 +1,114 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// One finished zone. Times are nanoseconds since the profiler was created.
+struct ProfileEvent {
+    const char* name;   // string literal, zones are told apart by pointer
+    uint64_t start;
+    uint64_t duration;
+    uint32_t thread;    // small per-thread number, in order of first use
+    uint32_t depth;     // nesting on its thread, 0 for outermost zones
+};
+
+// Per zone totals over the last frames, see Profiler::GetZoneStats
+struct ZoneStats {
+    const char* name;
+    int calls;
+    double totalMs;
+    double maxMs;
+};
+
+const size_t PROFILE_CAPACITY = 1 << 15;  // events kept, oldest get overwritten
+const int PROFILE_FRAMES = 240;           // frame times kept for the graph
+
+// Collects timing zones from any thread into a fixed ring buffer. Writers
+// only do an atomic increment and a few stores, no locks, so zones can sit
+// in the simulation hot path. Off until SetEnabled(true), disabled zones
+// cost one relaxed load. Create the instance on the main thread, the
+// first SetEnabled does that.
+class Profiler {
+private:
+    static Profiler* instance;
+    // Static so disabled zones never touch the instance
+    static std::atomic<bool> enabled;
+
+    // The sequence tells readers whether the event is complete and which
+    // lap of the ring it belongs to. Fields are relaxed atomics so a reader
+    // racing a writer gets a stale value it will discard, not a data race.
+    struct Slot {
+        std::atomic<uint64_t> sequence;
+        std::atomic<const char*> name;
+        std::atomic<uint64_t> start;
+        std::atomic<uint64_t> duration;
+        std::atomic<uint32_t> thread;
+        std::atomic<uint32_t> depth;
+    };
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<uint64_t> head;
+    std::chrono::steady_clock::time_point epoch;
+
+    // Main thread only, written by MarkFrame
+    float frameTimes[PROFILE_FRAMES];   // milliseconds
+    uint64_t frameStarts[PROFILE_FRAMES];
+    uint64_t frameCount;
+    uint64_t lastFrame;
+
+    Profiler();
+
+public:
+    static Profiler* GetInstance();
+    static void DestroyInstance();
+
+    void SetEnabled(bool value);
+    static bool IsEnabled() {
+        return enabled.load(std::memory_order_relaxed);
+    }
+    uint64_t Now() const;
+    void Record(const char* name, uint64_t start, uint64_t end, uint32_t depth);
+    // Call once per frame from the main thread
+    void MarkFrame();
+
+    // Events still in the ring, oldest first. Events being written while
+    // this runs are skipped.
+    std::vector<ProfileEvent> GetEvents() const;
+    // Totals per zone over the last frames, slowest first
+    std::vector<ZoneStats> GetZoneStats(int frames) const;
+    bool ExportCsv(const std::string& path, std::string& error) const;
+    // Chrome trace event format, open in chrome://tracing or Perfetto
+    bool ExportChromeTrace(const std::string& path, std::string& error) const;
+    // Frame time graph and zone table, in screen space
+    void DrawOverlay(int x, int y) const;
+};
+
+// Times its own scope, nested zones show up as children
+class ProfileZone {
+private:
+    const char* name;
+    uint64_t start;
+    bool active;
+
+public:
+    explicit ProfileZone(const char* zoneName);
+    ~ProfileZone();
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+};
+
+// Zones compile away entirely unless BOMBER_PROFILER is defined
+#ifdef BOMBER_PROFILER
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name)
+#endif
+
+#endif
@@ -0,0 +1,176 @@
+#include "Replay.h"
+#include <cstring>
+#include <fstream>
+
+uint8_t PackInput(const SimInput& input) {
+    // Two bits per axis: 0 idle, 1 positive, 2 negative. Bit 4 is the shot.
+    uint8_t packed = 0;
+    packed |= input.move.x > 0 ? 1 : (input.move.x < 0 ? 2 : 0);
+    packed |= (input.move.y > 0 ? 1 : (input.move.y < 0 ? 2 : 0)) << 2;
+    packed |= input.shoot ? 1 << 4 : 0;
+    return packed;
+}
+
+SimInput UnpackInput(uint8_t packed) {
+    static const float axis[] = {0.0f, 1.0f, -1.0f, 0.0f};
+    SimInput input = {{axis[packed & 3], axis[(packed >> 2) & 3]}, (packed & (1 << 4)) != 0};
+    if (input.move.x != 0 && input.move.y != 0) {
+        input.move.x *= 0.707f;
+        input.move.y *= 0.707f;
+    }
+    return input;
+}
+
+Replay::Replay() : tickCount(0), endHash(0), cursorRun(0), cursorTick(0) {}
+
+void Replay::Begin(const std::string& level) {
+    levelPath = level;
+    runs.clear();
+    tickCount = 0;
+    endHash = 0;
+    Rewind();
+}
+
+void Replay::Record(const SimInput& input) {
+    uint8_t packed = PackInput(input);
+    if (!runs.empty() && runs.back().input == packed && runs.back().ticks < UINT32_MAX) {
+        runs.back().ticks++;
+    } else {
+        runs.push_back({packed, 1});
+    }
+    tickCount++;
+}
+
+void Replay::Finish(uint64_t stateHash) {
+    endHash = stateHash;
+}
+
+template <typename T>
+static void WriteValue(std::ofstream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static bool ReadValue(std::ifstream& in, T& value) {
+    return (bool)in.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+bool Replay::Save(const std::string& path, std::string& error) const {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        error = "cannot write " + path;
+        return false;
+    }
+
+    out.write(REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+    WriteValue<uint16_t>(out, REPLAY_VERSION);
+    WriteValue<uint16_t>(out, (uint16_t)levelPath.size());
+    out.write(levelPath.data(), levelPath.size());
+    WriteValue<uint32_t>(out, tickCount);
+    WriteValue<uint64_t>(out, endHash);
+    WriteValue<uint32_t>(out, (uint32_t)runs.size());
+
+    // Most runs are short, so the count takes one or two bytes
+    for (const InputRun& run : runs) {
+        WriteValue<uint8_t>(out, run.input);
+        uint32_t ticks = run.ticks;
+        do {
+            uint8_t byte = ticks & 0x7f;
+            ticks >>= 7;
+            WriteValue<uint8_t>(out, ticks ? byte | 0x80 : byte);
+        } while (ticks);
+    }
+
+    if (!out) {
+        error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+bool Replay::Load(const std::string& path, std::string& error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    char magic[4];
+    uint16_t version = 0;
+    uint16_t pathLength = 0;
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, REPLAY_MAGIC, sizeof(magic)) != 0) {
+        error = path + " is not a replay";
+        return false;
+    }
+    if (!ReadValue(in, version) || version != REPLAY_VERSION) {
+        error = path + " has unsupported version " + std::to_string(version);
+        return false;
+    }
+
+    uint32_t runCount = 0;
+    std::string level;
+    if (ReadValue(in, pathLength)) {
+        level.resize(pathLength);
+        in.read(&level[0], pathLength);
+    }
+    if (!in || !ReadValue(in, tickCount) || !ReadValue(in, endHash) || !ReadValue(in, runCount)) {
+        error = path + " is truncated";
+        return false;
+    }
+    levelPath = level;
+
+    runs.clear();
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < runCount; i++) {
+        InputRun run = {0, 0};
+        uint8_t byte = 0;
+        if (!ReadValue(in, run.input)) break;
+        for (int shift = 0; shift < 35 && ReadValue(in, byte); shift += 7) {
+            run.ticks |= (uint32_t)(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) break;
+        }
+        if (!in || run.ticks == 0) break;
+        runs.push_back(run);
+        total += run.ticks;
+    }
+    if (runs.size() != runCount || total != tickCount) {
+        error = path + " is truncated";
+        runs.clear();
+        return false;
+    }
+
+    Rewind();
+    return true;
+}
+
+void Replay::Rewind() {
+    cursorRun = 0;
+    cursorTick = 0;
+}
+
+bool Replay::Next(SimInput& input) {
+    if (cursorRun >= runs.size()) return false;
+
+    input = UnpackInput(runs[cursorRun].input);
+    if (++cursorTick >= runs[cursorRun].ticks) {
+        cursorRun++;
+        cursorTick = 0;
+    }
+    return true;
+}
+
+const std::string& Replay::GetLevelPath() const {
+    return levelPath;
+}
+
+uint32_t Replay::GetTickCount() const {
+    return tickCount;
+}
+
+uint64_t Replay::GetEndHash() const {
+    return endHash;
+}
+
+size_t Replay::GetRunCount() const {
+    return runs.size();
+}
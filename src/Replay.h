@@ -0,0 +1,58 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "SimInput.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// .bbr files, little-endian: magic, version, the level path, tick count,
+// end state hash, then the input runs as a byte plus a LEB128 tick count.
+// The version goes up whenever the state hash changes, so old recordings
+// are refused instead of reported as diverged.
+const char REPLAY_MAGIC[4] = {'B', 'B', 'R', 'P'};
+const uint16_t REPLAY_VERSION = 3;
+
+// Consecutive ticks that all had the same input
+struct InputRun {
+    uint8_t input;  // PackInput
+    uint32_t ticks;
+};
+
+// Moves are -1, 0 or 1 per axis with diagonals scaled the way
+// Game::ReadInput does it, so a whole tick fits in one byte
+uint8_t PackInput(const SimInput& input);
+SimInput UnpackInput(uint8_t packed);
+
+// A recorded session: the level it was played on, the input of every tick
+// and LevelManager::GetStateHash after the last one. Playing the inputs
+// back on the same level must end on the same hash.
+class Replay {
+private:
+    std::string levelPath;
+    std::vector<InputRun> runs;
+    uint32_t tickCount;
+    uint64_t endHash;
+    // Playback position
+    size_t cursorRun;
+    uint32_t cursorTick;
+
+public:
+    Replay();
+    void Begin(const std::string& level);
+    void Record(const SimInput& input);
+    void Finish(uint64_t stateHash);
+    bool Save(const std::string& path, std::string& error) const;
+    bool Load(const std::string& path, std::string& error);
+
+    void Rewind();
+    // Input for the next tick, false once every recorded tick was played
+    bool Next(SimInput& input);
+
+    const std::string& GetLevelPath() const;
+    uint32_t GetTickCount() const;
+    uint64_t GetEndHash() const;
+    size_t GetRunCount() const;
+};
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef SIMINPUT_H
+#define SIMINPUT_H
+
+#include "raylib.h"
+
+// Simulation runs at a fixed rate independent of the render rate
+const float SIM_TIMESTEP = 1.0f / 120.0f;
+
+// Commands for one simulation step. Game fills this from the keyboard,
+// headless runs fill it from a script or a recording.
+struct SimInput {
+    Vector2 move;   // movement direction, {0, 0} when idle
+    bool shoot;     // fire this step (edge triggered, not held)
+};
+
+#endif
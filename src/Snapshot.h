@@ -0,0 +1,64 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+// Flat byte copy of the simulation state, filled by
+// LevelManager::SaveSnapshot. Only plain values go in, so a snapshot can be
+// copied, kept around or written to disk as raw bytes. Clear keeps the
+// buffer, so saving into the same snapshot again doesn't allocate.
+class Snapshot {
+private:
+    std::vector<unsigned char> bytes;
+
+public:
+    void Clear() {
+        bytes.clear();
+    }
+
+    void Write(const void* data, size_t size) {
+        size_t offset = bytes.size();
+        bytes.resize(offset + size);
+        std::memcpy(bytes.data() + offset, data, size);
+    }
+
+    template <typename T>
+    void WriteValue(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshots only hold plain values");
+        Write(&value, sizeof(T));
+    }
+
+    // Reads advance offset, false if the snapshot ends first
+    bool Read(size_t& offset, void* data, size_t size) const {
+        if (size > bytes.size() - offset) return false;
+        std::memcpy(data, bytes.data() + offset, size);
+        offset += size;
+        return true;
+    }
+
+    // Advances offset without reading, false if the snapshot ends first
+    bool Skip(size_t& offset, size_t size) const {
+        if (size > bytes.size() - offset) return false;
+        offset += size;
+        return true;
+    }
+
+    template <typename T>
+    bool ReadValue(size_t& offset, T& value) const {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshots only hold plain values");
+        return Read(offset, &value, sizeof(T));
+    }
+
+    size_t Size() const {
+        return bytes.size();
+    }
+
+    const unsigned char* Data() const {
+        return bytes.data();
+    }
+};
+
+#endif
@@ -0,0 +1,73 @@
+#include "SpatialHash.h"
+#include <cmath>
+
+SpatialHash::SpatialHash(float size) : cellSize(size), queryStamp(0), bucketMask(0) {}
+
+void SpatialHash::Clear() {
+    ids.clear();
+    ranges.clear();
+    entries.clear();
+    bucketStart.clear();
+}
+
+void SpatialHash::Insert(uint32_t id, Rectangle bounds) {
+    ids.push_back(id);
+    ranges.push_back(CellsOf(bounds));
+}
+
+SpatialHash::CellRange SpatialHash::CellsOf(Rectangle rect) const {
+    return {(int)std::floor(rect.x / cellSize), (int)std::floor(rect.y / cellSize),
+            (int)std::floor((rect.x + rect.width) / cellSize), (int)std::floor((rect.y + rect.height) / cellSize)};
+}
+
+uint32_t SpatialHash::Bucket(int cellX, int cellY) const {
+    return ((uint32_t)cellX * 73856093u ^ (uint32_t)cellY * 19349663u) & bucketMask;
+}
+
+void SpatialHash::Build() {
+    size_t entryCount = 0;
+    for (const CellRange& range : ranges) {
+        entryCount += (size_t)(range.maxX - range.minX + 1) * (range.maxY - range.minY + 1);
+    }
+
+    // About two buckets per entry keeps unrelated cells apart
+    uint32_t bucketCount = 16;
+    while (bucketCount < entryCount * 2) {
+        bucketCount *= 2;
+    }
+    bucketMask = bucketCount - 1;
+
+    // Count per bucket and sum up to where each bucket ends, then place
+    // back to front so every count ends up where its bucket starts
+    bucketStart.assign(bucketCount + 1, 0);
+    for (const CellRange& range : ranges) {
+        for (int y = range.minY; y <= range.maxY; y++) {
+            for (int x = range.minX; x <= range.maxX; x++) {
+                bucketStart[Bucket(x, y)]++;
+            }
+        }
+    }
+    for (uint32_t bucket = 1; bucket < bucketCount; bucket++) {
+        bucketStart[bucket] += bucketStart[bucket - 1];
+    }
+    bucketStart[bucketCount] = (uint32_t)entryCount;
+
+    // Bodies in reverse, so each bucket lists them in insertion order
+    entries.resize(entryCount);
+    for (uint32_t body = (uint32_t)ranges.size(); body-- > 0;) {
+        const CellRange& range = ranges[body];
+        for (int y = range.maxY; y >= range.minY; y--) {
+            for (int x = range.maxX; x >= range.minX; x--) {
+                entries[--bucketStart[Bucket(x, y)]] = {x, y, body};
+            }
+        }
+    }
+
+    if (queryStamps.size() < ranges.size()) {
+        queryStamps.resize(ranges.size(), 0);
+    }
+}
+
+size_t SpatialHash::GetBodyCount() const {
+    return ids.size();
+}
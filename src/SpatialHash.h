@@ -0,0 +1,102 @@
+#ifndef SPATIALHASH_H
+#define SPATIALHASH_H
+
+#include "raylib.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Broadphase for moving bodies: a grid of square cells, hashed so it needs
+// no bounds, rebuilt from scratch every tick. Insert every body, Build,
+// then ask for candidate pairs or for the bodies near a rect. Candidates
+// only share a cell, the caller does the exact Rectangle test.
+//
+// Build is a counting sort of (cell, body) entries into hash buckets, so
+// it allocates nothing once the buffers have grown and costs the same
+// whatever the bodies did last tick.
+class SpatialHash {
+private:
+    struct CellRange {
+        int minX;
+        int minY;
+        int maxX;
+        int maxY;
+    };
+
+    struct Entry {
+        int cellX;  // buckets are shared by unrelated cells on collisions
+        int cellY;
+        uint32_t body;
+    };
+
+    float cellSize;
+    std::vector<uint32_t> ids;
+    std::vector<CellRange> ranges;
+    std::vector<uint32_t> bucketStart;  // bucketCount + 1 offsets into entries
+    std::vector<Entry> entries;
+    std::vector<uint32_t> queryStamps;  // per body, the last Query that saw it
+    uint32_t queryStamp;
+    uint32_t bucketMask;
+
+    CellRange CellsOf(Rectangle rect) const;
+    uint32_t Bucket(int cellX, int cellY) const;
+
+public:
+    // Cells should be about as big as the bodies, a body spanning many
+    // cells is entered in each of them
+    explicit SpatialHash(float cellSize = 64.0f);
+    void Clear();
+    void Insert(uint32_t id, Rectangle bounds);
+    void Build();
+    size_t GetBodyCount() const;
+
+    // Calls visit(idA, idB) once for every two bodies that share a cell,
+    // after Build. A pair is reported from the first cell they share.
+    template <typename Visit>
+    void ForEachPair(Visit&& visit) const {
+        for (size_t bucket = 0; bucket + 1 < bucketStart.size(); bucket++) {
+            for (uint32_t i = bucketStart[bucket]; i < bucketStart[bucket + 1]; i++) {
+                const Entry& a = entries[i];
+                const CellRange& rangeA = ranges[a.body];
+                for (uint32_t j = i + 1; j < bucketStart[bucket + 1]; j++) {
+                    const Entry& b = entries[j];
+                    if (a.cellX != b.cellX || a.cellY != b.cellY) continue;
+
+                    const CellRange& rangeB = ranges[b.body];
+                    int firstX = rangeA.minX > rangeB.minX ? rangeA.minX : rangeB.minX;
+                    int firstY = rangeA.minY > rangeB.minY ? rangeA.minY : rangeB.minY;
+                    if (a.cellX == firstX && a.cellY == firstY) {
+                        visit(ids[a.body], ids[b.body]);
+                    }
+                }
+            }
+        }
+    }
+
+    // Calls visit(id) once for every body sharing a cell with rect, after
+    // Build. Bodies come in no particular order.
+    template <typename Visit>
+    void Query(Rectangle rect, Visit&& visit) {
+        if (entries.empty()) return;
+        if (++queryStamp == 0) {
+            // Wrapped around, old stamps could match again
+            queryStamps.assign(queryStamps.size(), 0);
+            queryStamp = 1;
+        }
+
+        CellRange cells = CellsOf(rect);
+        for (int y = cells.minY; y <= cells.maxY; y++) {
+            for (int x = cells.minX; x <= cells.maxX; x++) {
+                uint32_t bucket = Bucket(x, y);
+                for (uint32_t i = bucketStart[bucket]; i < bucketStart[bucket + 1]; i++) {
+                    const Entry& entry = entries[i];
+                    if (entry.cellX != x || entry.cellY != y || queryStamps[entry.body] == queryStamp) continue;
+                    queryStamps[entry.body] = queryStamp;
+                    visit(ids[entry.body]);
+                }
+            }
+        }
+    }
+};
+
+#endif
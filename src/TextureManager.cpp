@@ -1,5 +1,7 @@
 #include "TextureManager.h"
+#include "Profiler.h"
 #include <iostream>
+#include <algorithm>
 
 TextureManager* TextureManager::instance = nullptr;
 
@@ -17,48 +19,223 @@ void TextureManager::DestroyInstance() {
     }
 }
 
+TextureManager::TextureManager() : atlas{}, jobsInFlight(0), jobsTotal(0) {}
+
 TextureManager::~TextureManager() {
+    JoinWorkers();
     UnloadAllTextures();
 }
 
-void TextureManager::LoadTexture(const std::string& name, const std::string& filePath) {
-    if (textures.find(name) == textures.end()) 
+SpriteId TextureManager::LoadTexture(const std::string& name, const std::string& filePath) {
+    PROFILE_ZONE("TextureManager::LoadTexture");
+    SpriteId id = GetSpriteId(name);
+    if (images[id].data != nullptr) {
+        return id;
+    }
+
+    Image image = LoadImage(filePath.c_str());
+    if (image.data != nullptr) 
+    {
+        ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        images[id] = image;
+        std::cout << "Loaded texture: " << name << std::endl;
+    } 
+    else 
     {
-        Texture2D texture = ::LoadTexture(filePath.c_str());
-        if (texture.id != 0) 
+        std::cout << "Failed to load texture: " << filePath << std::endl;
+    }
+    return id;
+}
+
+void TextureManager::BuildAtlas() {
+    PROFILE_ZONE("TextureManager::BuildAtlas");
+    // Shelf packing: tallest images first, fill rows left to right
+    std::vector<SpriteId> order;
+    int totalArea = 0;
+    int widest = 0;
+    for (SpriteId id = 0; id < (SpriteId)images.size(); id++) {
+        if (images[id].data == nullptr) continue;
+        order.push_back(id);
+        totalArea += (images[id].width + 1) * (images[id].height + 1);
+        widest = std::max(widest, images[id].width + 1);
+    }
+    if (order.empty()) return;
+
+    std::sort(order.begin(), order.end(), [this](SpriteId a, SpriteId b) {
+        return images[a].height > images[b].height;
+    });
+
+    int atlasWidth = 64;
+    while (atlasWidth * atlasWidth < totalArea || atlasWidth < widest) {
+        atlasWidth *= 2;
+    }
+
+    // 1px gap between sprites so filtering never samples a neighbour
+    int x = 0;
+    int y = 0;
+    int rowHeight = 0;
+    for (SpriteId id : order) {
+        const Image& image = images[id];
+        if (x + image.width > atlasWidth) {
+            x = 0;
+            y += rowHeight + 1;
+            rowHeight = 0;
+        }
+        spriteRects[id] = {(float)x, (float)y, (float)image.width, (float)image.height};
+        x += image.width + 1;
+        rowHeight = std::max(rowHeight, image.height);
+    }
+    int atlasHeight = y + rowHeight;
+
+    Image atlasImage = GenImageColor(atlasWidth, atlasHeight, BLANK);
+    for (SpriteId id : order) {
+        Rectangle source = {0, 0, (float)images[id].width, (float)images[id].height};
+        ImageDraw(&atlasImage, images[id], source, spriteRects[id], WHITE);
+    }
+
+    if (atlas.id != 0) {
+        ::UnloadTexture(atlas); // call global (raylib) function
+    }
+    atlas = LoadTextureFromImage(atlasImage);
+    UnloadImage(atlasImage);
+    std::cout << "Built texture atlas: " << atlasWidth << "x" << atlasHeight
+              << " with " << order.size() << " sprites" << std::endl;
+}
+
+void TextureManager::QueueTexture(const std::string& name, const std::string& filePath) {
+    SpriteId id = GetSpriteId(name);
+    if (images[id].data != nullptr) return;
+
+    std::lock_guard<std::mutex> lock(loadMutex);
+    queuedJobs.push_back({id, name, filePath, Image{}});
+    jobsInFlight++;
+    jobsTotal++;
+}
+
+void TextureManager::StartLoading() {
+    int queued = 0;
+    {
+        std::lock_guard<std::mutex> lock(loadMutex);
+        queued = (int)queuedJobs.size();
+    }
+
+    // Workers exit once the queue is empty, so never start more than there are jobs
+    int threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+    threadCount = std::min(threadCount, queued);
+    for (int i = 0; i < threadCount; i++) {
+        workers.emplace_back(&TextureManager::DecodeWorker, this);
+    }
+}
+
+void TextureManager::DecodeWorker() {
+    while (true) {
+        DecodeJob job;
         {
-            textures[name] = texture;
-            std::cout << "Loaded texture: " << name << std::endl;
-        } 
-        else 
+            std::lock_guard<std::mutex> lock(loadMutex);
+            if (queuedJobs.empty()) return;
+            job = std::move(queuedJobs.front());
+            queuedJobs.pop_front();
+        }
+
+        // File read and PNG decode are CPU only and safe off the main thread
         {
-            std::cout << "Failed to load texture: " << filePath << std::endl;
+            PROFILE_ZONE("TextureManager::Decode");
+            job.image = LoadImage(job.filePath.c_str());
+            if (job.image.data != nullptr) {
+                ImageFormat(&job.image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(loadMutex);
+        decodedJobs.push_back(std::move(job));
+    }
+}
+
+void TextureManager::Update() {
+    if (jobsInFlight == 0) return;
+
+    std::vector<DecodeJob> finished;
+    {
+        std::lock_guard<std::mutex> lock(loadMutex);
+        finished.swap(decodedJobs);
+    }
+
+    for (DecodeJob& job : finished) {
+        jobsInFlight--;
+        if (job.image.data != nullptr) {
+            images[job.id] = job.image;
+            std::cout << "Loaded texture: " << job.name << std::endl;
+        } else {
+            std::cout << "Failed to load texture: " << job.filePath << std::endl;
         }
     }
+
+    // Only the final upload happens here, once everything is decoded
+    if (jobsInFlight == 0) {
+        JoinWorkers();
+        BuildAtlas();
+        jobsTotal = 0;
+    }
+}
+
+bool TextureManager::IsLoading() const {
+    return jobsInFlight > 0;
+}
+
+float TextureManager::GetLoadProgress() const {
+    if (jobsTotal == 0) return 1.0f;
+    return 1.0f - (float)jobsInFlight / jobsTotal;
+}
+
+void TextureManager::JoinWorkers() {
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
 }
 
-Texture2D& TextureManager::GetTexture(const std::string& name) {
-    auto it = textures.find(name);
-    if (it != textures.end()) {
+SpriteId TextureManager::GetSpriteId(const std::string& name) {
+    auto it = spriteIds.find(name);
+    if (it != spriteIds.end()) {
         return it->second;
     }
-    
-    // Return a default texture or handle error
-    static Texture2D defaultTexture{};
-    return defaultTexture;
+
+    SpriteId id = (SpriteId)spriteRects.size();
+    spriteIds[name] = id;
+    spriteRects.push_back({0, 0, 0, 0});
+    images.push_back(Image{});
+    return id;
 }
 
-void TextureManager::UnloadTexture(const std::string& name) {
-    auto it = textures.find(name);
-    if (it != textures.end()) {
-        ::UnloadTexture(it->second); // call global (raylib) function
-        textures.erase(it);
+Rectangle TextureManager::GetSpriteRect(SpriteId id) const {
+    if (id < 0 || id >= (SpriteId)spriteRects.size()) {
+        return {0, 0, 0, 0};
     }
+    return spriteRects[id];
+}
+
+const Texture2D& TextureManager::GetAtlas() const {
+    return atlas;
+}
+
+void TextureManager::DrawSprite(SpriteId id, Rectangle dest, Vector2 origin, float rotation, Color tint) const {
+    Rectangle source = GetSpriteRect(id);
+    // Missing or not yet packed sprites draw nothing
+    if (atlas.id == 0 || source.width == 0) return;
+
+    DrawTexturePro(atlas, source, dest, origin, rotation, tint);
 }
 
 void TextureManager::UnloadAllTextures() {
-    for (auto& pair : textures) {
-        ::UnloadTexture(pair.second); // call global (raylib) function
+    for (Image& image : images) {
+        if (image.data != nullptr) {
+            UnloadImage(image);
+            image = Image{};
+        }
+    }
+    if (atlas.id != 0) {
+        ::UnloadTexture(atlas); // call global (raylib) function
+        atlas = Texture2D{};
     }
-    textures.clear();
+    std::fill(spriteRects.begin(), spriteRects.end(), Rectangle{0, 0, 0, 0});
 }
@@ -2,24 +2,72 @@
 #define TEXTUREMANAGER_H
 
 #include "raylib.h"
+#include <deque>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 #include <string>
+#include <vector>
+
+// Index of a sprite inside the atlas. Look it up once by name and keep it,
+// drawing with it needs no string work.
+using SpriteId = int;
+const SpriteId INVALID_SPRITE = -1;
 
 class TextureManager {
 private:
-    std::unordered_map<std::string, Texture2D> textures;
+    struct DecodeJob {
+        SpriteId id;
+        std::string name;
+        std::string filePath;
+        Image image;
+    };
+
+    std::unordered_map<std::string, SpriteId> spriteIds;
+    std::vector<Image> images;          // decoded, kept so the atlas can be rebuilt
+    std::vector<Rectangle> spriteRects; // region of each sprite in the atlas
+    Texture2D atlas;
     static TextureManager* instance;
 
-    TextureManager() = default;
+    // Background decoding. Workers take jobs from queuedJobs and hand them
+    // back through decodedJobs, both guarded by loadMutex. Everything that
+    // talks to the GPU stays on the main thread in Update.
+    std::vector<std::thread> workers;
+    std::mutex loadMutex;
+    std::deque<DecodeJob> queuedJobs;
+    std::vector<DecodeJob> decodedJobs;
+    int jobsInFlight;   // queued or decoding, main thread only
+    int jobsTotal;
+    void DecodeWorker();
+    void JoinWorkers();
+
+    TextureManager();
     ~TextureManager();
 
 public:
     static TextureManager* GetInstance();
     static void DestroyInstance();
 
-    void LoadTexture(const std::string& name, const std::string& filePath);
-    Texture2D& GetTexture(const std::string& name);
-    void UnloadTexture(const std::string& name);
+    // Decodes the image; it becomes drawable after the next BuildAtlas
+    SpriteId LoadTexture(const std::string& name, const std::string& filePath);
+    // Packs every loaded image into one texture and uploads it
+    void BuildAtlas();
+
+    // Async loading: queue files, start the decode threads, then call
+    // Update once per frame until IsLoading() turns false
+    void QueueTexture(const std::string& name, const std::string& filePath);
+    void StartLoading();
+    void Update();
+    bool IsLoading() const;
+    float GetLoadProgress() const;
+    // Registers the name if it hasn't been loaded yet, so ids can be
+    // resolved before the textures exist
+    SpriteId GetSpriteId(const std::string& name);
+    Rectangle GetSpriteRect(SpriteId id) const;
+    const Texture2D& GetAtlas() const;
+    // Everything drawn through here shares one texture, so raylib keeps
+    // consecutive sprites in the same batch
+    void DrawSprite(SpriteId id, Rectangle dest, Vector2 origin, float rotation, Color tint) const;
     void UnloadAllTextures();
 };
 
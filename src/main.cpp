@@ -1,9 +1,29 @@
 #include "raylib.h"
 #include "Game.h"
+#include <cstring>
+#include <filesystem>
+#include <string>
 
-int main()
+// Pass a .bbr file to watch a recorded session instead of playing, or
+// --connect host[:port] to join a bomber_server match
+int main(int argc, char** argv)
 {
+    std::string connectAddress;
+    std::string replayPath;
+    if (argc > 2 && std::strcmp(argv[1], "--connect") == 0) {
+        connectAddress = argv[2];
+    } else if (argc > 1) {
+        // Game changes into the project folder, resolve the path before that
+        replayPath = std::filesystem::absolute(argv[1]).string();
+    }
+
     Game game;
+    if (!replayPath.empty() && !game.StartReplay(replayPath)) {
+        return 1;
+    }
+    if (!connectAddress.empty() && !game.StartRemote(connectAddress)) {
+        return 1;
+    }
     game.Run();
     return 0;
 }
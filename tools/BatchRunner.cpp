@@ -0,0 +1,298 @@
+// bomber_batch: runs many headless matches in parallel and sums up the results.
+//
+//   bomber_batch [options] <level.bbl>...
+//     -n <matches>    number of matches, spread over the levels (default 100)
+//     -j <threads>    worker threads (default: one per core)
+//     -s <seed>       base seed, match i uses seed + i (default 1)
+//     -p <policy>     random, or script:<file> (default random)
+//     -o <file.csv>   also write one line per match
+//
+// A script file holds one step per line, "<ticks> <dx> <dy> <shoot>", so
+// "120 1 0 0" drives right for one second. Lines starting with ';' are
+// comments, the player idles once the script runs out.
+//
+// Matches only depend on their level, seed and policy, never on which
+// thread ran them, so the same command line always gives the same results.
+
+#include "LevelFile.h"
+#include "LevelManager.h"
+#include "SimInput.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ScriptStep {
+    int ticks;
+    SimInput input;
+};
+
+struct MatchResult {
+    LevelStatus status;
+    bool died;
+    int ticks;
+    int tilesDestroyed;
+    int remainingDestructibles;
+};
+
+// One deque per worker. The owner takes jobs from the back, idle workers
+// steal from the front, so they rarely want the same end.
+class WorkQueue {
+private:
+    std::mutex mutex;
+    std::deque<int> jobs;
+
+public:
+    void Push(int job) {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(job);
+    }
+
+    bool Pop(int& job) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (jobs.empty()) return false;
+        job = jobs.back();
+        jobs.pop_back();
+        return true;
+    }
+
+    bool Steal(int& job) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (jobs.empty()) return false;
+        job = jobs.front();
+        jobs.pop_front();
+        return true;
+    }
+};
+
+static bool LoadScript(const std::string& path, std::vector<ScriptStep>& script) {
+    std::ifstream input(path);
+    if (!input) {
+        std::cerr << "cannot open " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(input, line)) {
+        lineNumber++;
+        if (line.empty() || line[0] == ';' || line[0] == '\r') continue;
+
+        std::istringstream fields(line);
+        ScriptStep step = {};
+        int shoot = 0;
+        if (!(fields >> step.ticks >> step.input.move.x >> step.input.move.y >> shoot) || step.ticks <= 0) {
+            std::cerr << path << ":" << lineNumber << ": expected <ticks> <dx> <dy> <shoot>" << std::endl;
+            return false;
+        }
+        step.input.shoot = shoot != 0;
+        script.push_back(step);
+    }
+    return true;
+}
+
+// Random policy: a new direction every quarter second, sometimes firing
+static SimInput RandomInput(std::mt19937& rng, int tick, SimInput current) {
+    if (tick % 30 != 0) {
+        current.shoot = false;
+        return current;
+    }
+
+    static const Vector2 directions[] = {{0, 0}, {1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    current.move = directions[rng() % 5];
+    current.shoot = rng() % 4 == 0;
+    return current;
+}
+
+static MatchResult RunMatch(const std::string& levelPath, uint32_t seed, const std::vector<ScriptStep>* script) {
+    MatchResult result = {LevelStatus::RUNNING, false, 0, 0, 0};
+
+    LevelManager level;
+    if (!level.LoadLevel(levelPath)) {
+        result.status = LevelStatus::LOST;
+        return result;
+    }
+    level.AddListener([&result](const LevelEvent& event) {
+        if (event.type == LevelEventType::TILE_DESTROYED) {
+            result.tilesDestroyed++;
+        }
+    });
+
+    std::mt19937 rng(seed);
+    SimInput input = {{0, 0}, false};
+    size_t step = 0;
+    int stepTicks = 0;
+
+    while (level.GetStatus() == LevelStatus::RUNNING) {
+        if (script) {
+            // Shots fire on the first tick of a step only
+            input = {{0, 0}, false};
+            if (step < script->size()) {
+                input = (*script)[step].input;
+                input.shoot = input.shoot && stepTicks == 0;
+                if (++stepTicks >= (*script)[step].ticks) {
+                    step++;
+                    stepTicks = 0;
+                }
+            }
+        } else {
+            input = RandomInput(rng, result.ticks, input);
+        }
+
+        level.Update(input, SIM_TIMESTEP);
+        result.ticks++;
+    }
+
+    result.status = level.GetStatus();
+    result.died = level.IsPlayerDead();
+    result.remainingDestructibles = level.GetRemainingDestructibles();
+    return result;
+}
+
+static const char* ResultName(const MatchResult& result) {
+    if (result.status == LevelStatus::WON) return "won";
+    if (result.died) return "died";
+    return result.ticks > 0 ? "timeout" : "error";
+}
+
+int main(int argc, char** argv) {
+    int matchCount = 100;
+    int threadCount = (int)std::max(1u, std::thread::hardware_concurrency());
+    uint32_t baseSeed = 1;
+    std::string policy = "random";
+    std::string csvPath;
+    std::vector<std::string> levels;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-n" && hasValue) {
+            matchCount = std::atoi(argv[++i]);
+        } else if (arg == "-j" && hasValue) {
+            threadCount = std::atoi(argv[++i]);
+        } else if (arg == "-s" && hasValue) {
+            baseSeed = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "-p" && hasValue) {
+            policy = argv[++i];
+        } else if (arg == "-o" && hasValue) {
+            csvPath = argv[++i];
+        } else if (!arg.empty() && arg[0] != '-') {
+            levels.push_back(arg);
+        } else {
+            levels.clear();
+            break;
+        }
+    }
+    if (levels.empty() || matchCount <= 0 || threadCount <= 0) {
+        std::cerr << "usage: bomber_batch [-n matches] [-j threads] [-s seed] "
+                     "[-p random|script:<file>] [-o results.csv] <level.bbl>..." << std::endl;
+        return 1;
+    }
+
+    std::vector<ScriptStep> script;
+    if (policy.compare(0, 7, "script:") == 0) {
+        if (!LoadScript(policy.substr(7), script)) return 1;
+    } else if (policy != "random") {
+        std::cerr << "unknown policy " << policy << std::endl;
+        return 1;
+    }
+    const std::vector<ScriptStep>* scriptPtr = policy == "random" ? nullptr : &script;
+
+    // Check every level once up front instead of failing in each match
+    for (const std::string& path : levels) {
+        LevelFile file;
+        std::string error;
+        if (!file.Open(path, error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<MatchResult> results(matchCount);
+    std::vector<WorkQueue> queues(threadCount);
+    for (int i = 0; i < matchCount; i++) {
+        queues[i % threadCount].Push(i);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (int self = 0; self < threadCount; self++) {
+        workers.emplace_back([&, self]() {
+            int match = 0;
+            while (true) {
+                bool found = queues[self].Pop(match);
+                // Out of own work, take the oldest job from someone else.
+                // Nothing adds jobs after start, so all empty means done.
+                for (int offset = 1; !found && offset < threadCount; offset++) {
+                    found = queues[(self + offset) % threadCount].Steal(match);
+                }
+                if (!found) break;
+
+                results[match] = RunMatch(levels[match % levels.size()], baseSeed + (uint32_t)match, scriptPtr);
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!csvPath.empty()) {
+        std::ofstream csv(csvPath);
+        if (!csv) {
+            std::cerr << "cannot write " << csvPath << std::endl;
+            return 1;
+        }
+        csv << "match,level,seed,result,ticks,tiles_destroyed,remaining_destructibles\n";
+        for (int i = 0; i < matchCount; i++) {
+            const MatchResult& result = results[i];
+            csv << i << "," << levels[i % levels.size()] << "," << baseSeed + (uint32_t)i << ","
+                << ResultName(result) << "," << result.ticks << "," << result.tilesDestroyed << ","
+                << result.remainingDestructibles << "\n";
+        }
+    }
+
+    long long totalTicks = 0;
+    for (const MatchResult& result : results) {
+        totalTicks += result.ticks;
+    }
+    std::cout << matchCount << " matches on " << threadCount << " threads in " << seconds << " s ("
+              << matchCount / seconds << " matches/s, " << totalTicks / seconds << " ticks/s)" << std::endl;
+
+    for (size_t level = 0; level < levels.size(); level++) {
+        int played = 0, won = 0, died = 0, timedOut = 0, failed = 0;
+        long long ticks = 0, destroyed = 0;
+        for (int i = (int)level; i < matchCount; i += (int)levels.size()) {
+            const MatchResult& result = results[i];
+            const char* name = ResultName(result);
+            played++;
+            ticks += result.ticks;
+            destroyed += result.tilesDestroyed;
+            if (std::strcmp(name, "won") == 0) won++;
+            else if (std::strcmp(name, "died") == 0) died++;
+            else if (std::strcmp(name, "timeout") == 0) timedOut++;
+            else failed++;
+        }
+        if (played == 0) continue;
+
+        std::cout << levels[level] << ": " << played << " played, " << won << " won, " << died << " died, "
+                  << timedOut << " timed out";
+        if (failed > 0) std::cout << ", " << failed << " failed to load";
+        std::cout << ", avg " << ticks / played << " ticks, avg " << (double)destroyed / played
+                  << " tiles destroyed" << std::endl;
+    }
+    return 0;
+}
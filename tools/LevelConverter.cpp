@@ -0,0 +1,117 @@
+// bomber_levelc: turns an ASCII level layout into a .bbl level file.
+//
+//   bomber_levelc levels/level1.txt levels/level1.bbl
+//
+// One character per tile, every row the same width, lines starting with
+// ';' are comments:
+//   #  wall           x  destructible    o  barrel
+//   *  power-up       S  spawn (once)    E  exit (once)
+//   T  enemy tank     .  empty
+
+#include "LevelFormat.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static bool ParseTile(char c, TileType& type) {
+    switch (c) {
+        case '.': type = TileType::EMPTY; return true;
+        case '#': type = TileType::WALL; return true;
+        case 'x': type = TileType::DESTRUCTIBLE; return true;
+        case 'o': type = TileType::BARREL; return true;
+        case '*': type = TileType::POWER_UP; return true;
+        case 'S': type = TileType::SPAWN_POINT; return true;
+        case 'E': type = TileType::EXIT_POINT; return true;
+        case 'T': type = TileType::ENEMY_SPAWN; return true;
+        default: return false;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::cerr << "usage: bomber_levelc <layout.txt> <level.bbl>" << std::endl;
+        return 1;
+    }
+
+    std::ifstream input(argv[1]);
+    if (!input) {
+        std::cerr << "cannot open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> rows;
+    std::string line;
+    while (std::getline(input, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == ';') continue;
+        rows.push_back(line);
+    }
+    if (rows.empty()) {
+        std::cerr << argv[1] << ": no tiles" << std::endl;
+        return 1;
+    }
+
+    LevelHeader header = {};
+    std::memcpy(header.magic, LEVEL_MAGIC, sizeof(LEVEL_MAGIC));
+    header.version = LEVEL_VERSION;
+    header.headerSize = sizeof(LevelHeader);
+    header.width = (uint32_t)rows[0].size();
+    header.height = (uint32_t)rows.size();
+
+    if (header.width > (uint32_t)MAX_LEVEL_SIZE || header.height > (uint32_t)MAX_LEVEL_SIZE) {
+        std::cerr << argv[1] << ": level larger than " << MAX_LEVEL_SIZE << " tiles per side" << std::endl;
+        return 1;
+    }
+
+    std::vector<Tile> tiles;
+    tiles.reserve((size_t)header.width * header.height);
+    int spawns = 0;
+    int exits = 0;
+
+    for (uint32_t y = 0; y < header.height; y++) {
+        if (rows[y].size() != header.width) {
+            std::cerr << argv[1] << ": row " << y + 1 << " is " << rows[y].size()
+                      << " tiles wide, expected " << header.width << std::endl;
+            return 1;
+        }
+        for (uint32_t x = 0; x < header.width; x++) {
+            TileType type;
+            if (!ParseTile(rows[y][x], type)) {
+                std::cerr << argv[1] << ": unknown tile '" << rows[y][x] << "' at "
+                          << x << "," << y << std::endl;
+                return 1;
+            }
+            if (type == TileType::SPAWN_POINT) {
+                header.spawnX = x;
+                header.spawnY = y;
+                spawns++;
+            } else if (type == TileType::EXIT_POINT) {
+                header.exitX = x;
+                header.exitY = y;
+                exits++;
+            } else if (type == TileType::DESTRUCTIBLE) {
+                header.destructibles++;
+            }
+            tiles.push_back({type, 0});
+        }
+    }
+
+    if (spawns != 1 || exits != 1) {
+        std::cerr << argv[1] << ": need exactly one S and one E" << std::endl;
+        return 1;
+    }
+
+    std::ofstream output(argv[2], std::ios::binary);
+    output.write((const char*)&header, sizeof(header));
+    output.write((const char*)tiles.data(), tiles.size() * sizeof(Tile));
+    if (!output) {
+        std::cerr << "cannot write " << argv[2] << std::endl;
+        return 1;
+    }
+
+    std::cout << argv[2] << ": " << header.width << "x" << header.height << ", "
+              << header.destructibles << " destructibles" << std::endl;
+    return 0;
+}
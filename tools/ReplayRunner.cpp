@@ -0,0 +1,87 @@
+// bomber_replay: plays a recorded session back without a window, as fast as
+// the simulation runs, and checks it ends in the recorded state.
+//
+//   bomber_replay [-n <runs>] <replay.bbr> [level.bbl]
+//
+// The level defaults to the path stored in the replay. With -n the replay
+// is played several times, which makes it a repeatable benchmark.
+// Exit code 0 when every run matched, 2 when one diverged.
+
+#include "LevelManager.h"
+#include "Replay.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+int main(int argc, char** argv) {
+    int runCount = 1;
+    std::string replayPath;
+    std::string levelPath;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-n" && i + 1 < argc) {
+            runCount = std::atoi(argv[++i]);
+        } else if (replayPath.empty()) {
+            replayPath = arg;
+        } else if (levelPath.empty()) {
+            levelPath = arg;
+        } else {
+            replayPath.clear();
+            break;
+        }
+    }
+    if (replayPath.empty() || runCount <= 0) {
+        std::cerr << "usage: bomber_replay [-n runs] <replay.bbr> [level.bbl]" << std::endl;
+        return 1;
+    }
+
+    Replay replay;
+    std::string error;
+    if (!replay.Load(replayPath, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    if (levelPath.empty()) {
+        levelPath = replay.GetLevelPath();
+    }
+
+    std::cout << replayPath << ": " << replay.GetTickCount() << " ticks in " << replay.GetRunCount()
+              << " runs on " << levelPath << std::endl;
+
+    LevelManager level;
+    bool matched = true;
+    double best = 0;
+    double total = 0;
+    for (int run = 0; run < runCount; run++) {
+        if (!level.LoadLevel(levelPath)) return 1;
+        replay.Rewind();
+
+        auto start = std::chrono::steady_clock::now();
+        SimInput input;
+        while (replay.Next(input)) {
+            level.Update(input, SIM_TIMESTEP);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        total += seconds;
+        best = run == 0 ? seconds : std::min(best, seconds);
+
+        uint64_t hash = level.GetStateHash();
+        if (hash != replay.GetEndHash()) {
+            char message[96];
+            std::snprintf(message, sizeof(message), "run %d diverged: hash %016llx, recorded %016llx", run + 1,
+                          (unsigned long long)hash, (unsigned long long)replay.GetEndHash());
+            std::cout << message << std::endl;
+            matched = false;
+        }
+    }
+
+    std::cout << "best " << best * 1000.0 << " ms (" << replay.GetTickCount() / best << " ticks/s), avg "
+              << total / runCount * 1000.0 << " ms" << std::endl;
+    std::cout << (matched ? "end state matches" : "end state differs") << std::endl;
+    return matched ? 0 : 2;
+}
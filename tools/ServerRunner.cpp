@@ -0,0 +1,97 @@
+// bomber_server: hosts a match of one level for up to NET_MAX_CLIENTS
+// players, with no window.
+//
+//   bomber_server [-p <port>] [-t <seconds>] <level.bbl>
+//
+// Listens on NET_DEFAULT_PORT unless -p says otherwise; players join with
+// BattleBomber --connect host[:port]. The level path is sent to them as
+// given, so run the server from the game's folder. The match starts over
+// a few seconds after it ends. Runs until Ctrl+C, or for -t seconds, and
+// prints the traffic every ten seconds.
+
+#include "MatchServer.h"
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+static volatile std::sig_atomic_t stopRequested = 0;
+
+static void RequestStop(int) {
+    stopRequested = 1;
+}
+
+int main(int argc, char** argv) {
+    int port = NET_DEFAULT_PORT;
+    double runSeconds = 0;
+    std::string levelPath;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-p" && i + 1 < argc) {
+            port = std::atoi(argv[++i]);
+        } else if (arg == "-t" && i + 1 < argc) {
+            runSeconds = std::atof(argv[++i]);
+        } else if (levelPath.empty()) {
+            levelPath = arg;
+        } else {
+            levelPath.clear();
+            break;
+        }
+    }
+    if (levelPath.empty() || port < 0 || port > 65535) {
+        std::cerr << "usage: bomber_server [-p port] [-t seconds] <level.bbl>" << std::endl;
+        return 1;
+    }
+
+    MatchServer server;
+    std::string error;
+    if (!server.Start(levelPath, (uint16_t)port, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    std::cout << "Serving " << levelPath << " on port " << server.GetPort() << std::endl;
+
+    std::signal(SIGINT, RequestStop);
+    std::signal(SIGTERM, RequestStop);
+
+    // Fixed rate against the clock, a late tick is caught up on the next ones
+    using Clock = std::chrono::steady_clock;
+    const auto step = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(SIM_TIMESTEP));
+    const uint32_t reportTicks = (uint32_t)(10.0f / SIM_TIMESTEP);
+    auto start = Clock::now();
+    auto next = start;
+    uint64_t ticks = 0;
+    uint64_t reportedSent = 0;
+    uint64_t reportedReceived = 0;
+
+    while (!stopRequested) {
+        server.Tick();
+        ticks++;
+        if (runSeconds > 0 && ticks * SIM_TIMESTEP >= runSeconds) break;
+
+        if (ticks % reportTicks == 0) {
+            uint64_t sent = server.GetBytesSent() - reportedSent;
+            uint64_t received = server.GetBytesReceived() - reportedReceived;
+            reportedSent = server.GetBytesSent();
+            reportedReceived = server.GetBytesReceived();
+            std::cout << server.GetClientCount() << " players, " << sent / 10 << " B/s out, " << received / 10
+                      << " B/s in, " << server.GetSnapshotsSent() << " snapshots (" << server.GetFullSnapshotsSent()
+                      << " full)" << std::endl;
+        }
+
+        next += step;
+        auto now = Clock::now();
+        if (now - next > std::chrono::seconds(1)) {
+            // Too far behind to catch up, carry on from here
+            next = now;
+        }
+        std::this_thread::sleep_until(next);
+    }
+
+    server.Stop();
+    std::cout << "Stopped after " << ticks << " ticks" << std::endl;
+    return 0;
+}